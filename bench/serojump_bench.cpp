@@ -0,0 +1,206 @@
+// serojump_bench - throughput of the SeroJump core's hot paths (Google Benchmark)
+//
+//   ./serojump_bench --benchmark_format=json --benchmark_out=native.json
+//
+// Benchmark names and arguments match bench/wasm_bench.js, so native and
+// WebAssembly results can be compared with Google Benchmark's compare.py.
+// Every benchmark reports items_per_second (samples or individual-steps per
+// second) plus an ns_per_sample or ns_per_step counter.
+#include <benchmark/benchmark.h>
+#include "serojump.hpp"
+
+#ifndef SEROJUMP_BUILD_TYPE
+#define SEROJUMP_BUILD_TYPE ""
+#endif
+
+// The scalar titre function the C interface exports (computeTitre is private)
+extern "C" double compute_titre(double baseline, double boost, double decay_rate,
+                                double infection_time, double sample_time);
+
+namespace {
+
+const StudyParams kStudy = { 0.0, 12.0, 1, 0.3, {} };
+const AntibodyParams kAntibody = { 2.0, 0.3, 2.0, 0.2, 0.1, 0.2 };
+
+StudyParams studyOf(int n_individuals) {
+    StudyParams study_params = kStudy;
+    study_params.n_individuals = n_individuals;
+    return study_params;
+}
+
+// Every individual infected, so the likelihood takes the post-infection path
+Cohort benchCohort(int n_individuals, int n_samples) {
+    StudyParams study_params = studyOf(n_individuals);
+    study_params.infection_rate = 0.999;
+    return SeroJumpSimulator(12345).simulateStudy(study_params, kAntibody, n_samples);
+}
+
+IndividualMCMC infectedState(const Cohort& cohort, SeroJumpSimulator& simulator) {
+    IndividualMCMC state = simulator.initialState(cohort.individual(0), kAntibody, kStudy);
+    state.infection_times.push_back(cohort.true_infection_times[0]);
+    state.log_likelihood = simulator.logLikelihood(cohort.individual(0), state, kAntibody);
+    state.log_prior = simulator.logPrior(state, kAntibody, kStudy);
+    return state;
+}
+
+benchmark::Counter perItem(double items_per_iteration) {
+    return benchmark::Counter(items_per_iteration,
+                              benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert,
+                              benchmark::Counter::OneK::kIs1000);
+}
+
+// Arg: samples
+void BM_ComputeTitre(benchmark::State& state) {
+    int n_samples = int(state.range(0));
+    Cohort cohort = benchCohort(1, n_samples);
+    double infection_time = cohort.true_infection_times[0];
+    for (auto _ : state) {
+        double sum = 0.0;
+        for (double t : cohort.sample_times) {
+            sum += compute_titre(2.0, 2.0, 0.1, infection_time, t);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * n_samples);
+    state.counters["ns_per_sample"] = perItem(n_samples * 1e-9);
+}
+BENCHMARK(BM_ComputeTitre)->ArgName("samples")->RangeMultiplier(4)->Range(4, 1024);
+
+// Arg: samples
+void BM_LogLikelihood(benchmark::State& state) {
+    int n_samples = int(state.range(0));
+    Cohort cohort = benchCohort(1, n_samples);
+    SeroJumpSimulator simulator(1);
+    IndividualMCMC params = infectedState(cohort, simulator);
+    IndividualView individual = cohort.individual(0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(simulator.logLikelihood(individual, params, kAntibody));
+    }
+    state.SetItemsProcessed(state.iterations() * n_samples);
+    state.counters["ns_per_sample"] = perItem(n_samples * 1e-9);
+}
+BENCHMARK(BM_LogLikelihood)->ArgName("samples")->RangeMultiplier(4)->Range(4, 1024);
+
+// Arg: samples. One step of a single chain, which carries on from step to step
+void BM_MCMCStepIndividual(benchmark::State& state) {
+    int n_samples = int(state.range(0));
+    Cohort cohort = benchCohort(1, n_samples);
+    SeroJumpSimulator simulator(1);
+    IndividualMCMC params = infectedState(cohort, simulator);
+    IndividualView individual = cohort.individual(0);
+    ProposalScales scales = ProposalScales::defaults(kStudy);
+    for (auto _ : state) {
+        params = simulator.mcmcStepIndividual(individual, params, scales, kAntibody, kStudy).params;
+        benchmark::DoNotOptimize(params.log_likelihood);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["ns_per_step"] = perItem(1e-9);
+}
+BENCHMARK(BM_MCMCStepIndividual)->ArgName("samples")->RangeMultiplier(4)->Range(4, 1024);
+
+// The same single-chain step through a registered cohort handle, i.e. what one
+// step costs a caller of the C interface
+void cohortStep(benchmark::State& state, int n_samples, int time_grid) {
+    Cohort cohort = benchCohort(1, n_samples);
+    SeroJumpSimulator simulator(1);
+    CohortHandle* handle = create_cohort_handle(&simulator, 1, cohort.ids.data(), cohort.sample_times.data(),
+                                                cohort.titre_values.data(), &n_samples);
+    cohort_set_model(handle, kStudy.study_start, kStudy.study_end, kStudy.infection_rate, 1,
+                     kAntibody.baseline_mean, kAntibody.baseline_sd, kAntibody.boost_mean,
+                     kAntibody.boost_sd, kAntibody.decay_rate, kAntibody.observation_sd, 0, 0,
+                     time_grid);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cohort_step_individual(handle, 0, 1));
+    }
+    destroy_cohort_handle(handle);
+    state.SetItemsProcessed(state.iterations());
+    state.counters["ns_per_step"] = perItem(1e-9);
+}
+
+// Arg: samples
+void BM_CohortStep(benchmark::State& state) {
+    cohortStep(state, int(state.range(0)), 0);
+}
+BENCHMARK(BM_CohortStep)->ArgName("samples")->RangeMultiplier(4)->Range(4, 1024);
+
+// Args: samples, cells. Infection-time moves from the grid proposal
+void BM_CohortStepGrid(benchmark::State& state) {
+    cohortStep(state, int(state.range(0)), int(state.range(1)));
+}
+BENCHMARK(BM_CohortStepGrid)->ArgNames({"samples", "cells"})->ArgsProduct({{16, 256}, {64, 512}});
+
+// Args: individuals, samples per individual
+void BM_SimulateStudy(benchmark::State& state) {
+    int n_individuals = int(state.range(0));
+    int n_samples = int(state.range(1));
+    SeroJumpSimulator simulator(1);
+    StudyParams study_params = studyOf(n_individuals);
+    for (auto _ : state) {
+        Cohort cohort = simulator.simulateStudy(study_params, kAntibody, n_samples);
+        benchmark::DoNotOptimize(cohort.titre_values.data());
+    }
+    int64_t total_samples = int64_t(n_individuals) * n_samples;
+    state.SetItemsProcessed(state.iterations() * total_samples);
+    state.counters["ns_per_sample"] = perItem(total_samples * 1e-9);
+}
+BENCHMARK(BM_SimulateStudy)->ArgNames({"individuals", "samples"})
+    ->ArgsProduct({{100, 1000, 10000}, {5, 20}});
+
+// Args: individuals, samples per individual. Large cohorts streamed through
+// simulateStudyChunked in chunks of 4096, so memory stays at one chunk
+void BM_SimulateStudyStream(benchmark::State& state) {
+    int n_individuals = int(state.range(0));
+    int n_samples = int(state.range(1));
+    SeroJumpSimulator simulator(1);
+    StudyParams study_params = studyOf(n_individuals);
+    for (auto _ : state) {
+        double sum = 0.0;
+        simulator.simulateStudyChunked(study_params, kAntibody, n_samples, 4096, 1,
+                                       [&](const Cohort& chunk) {
+            sum += chunk.titre_values.back();
+            return true;
+        });
+        benchmark::DoNotOptimize(sum);
+    }
+    int64_t total_samples = int64_t(n_individuals) * n_samples;
+    state.SetItemsProcessed(state.iterations() * total_samples);
+    state.counters["ns_per_sample"] = perItem(total_samples * 1e-9);
+}
+BENCHMARK(BM_SimulateStudyStream)->ArgNames({"individuals", "samples"})
+    ->ArgsProduct({{100000, 1000000}, {5}})->Unit(benchmark::kMillisecond);
+
+// Args: individuals, samples per individual, steps. The full study sweep
+// (streaming summary, half the steps burn-in) on one chain and one thread, so
+// items are individual-steps of a single core
+void BM_StudySweep(benchmark::State& state) {
+    int n_individuals = int(state.range(0));
+    int n_samples = int(state.range(1));
+    int n_steps = int(state.range(2));
+    Cohort cohort = benchCohort(n_individuals, n_samples);
+    StudyParams study_params = studyOf(n_individuals);
+    SeroJumpSimulator simulator(1);
+    for (auto _ : state) {
+        PosteriorSummary summary = simulator.runMCMCStudySummary(
+            cohort, kAntibody, study_params, n_steps, n_steps / 2, 1, 40, 1, 1);
+        benchmark::DoNotOptimize(summary.acceptance_rates.data());
+    }
+    int64_t individual_steps = int64_t(n_individuals) * n_steps;
+    state.SetItemsProcessed(state.iterations() * individual_steps);
+    state.counters["ns_per_step"] = perItem(individual_steps * 1e-9);
+}
+BENCHMARK(BM_StudySweep)->ArgNames({"individuals", "samples", "steps"})
+    ->ArgsProduct({{100, 1000}, {5, 20}, {1000}})
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    // Numbers from an unoptimised core are not worth tracking; say so in the output
+    benchmark::AddCustomContext("serojump_build_type", SEROJUMP_BUILD_TYPE[0] ? SEROJUMP_BUILD_TYPE : "none");
+    benchmark::AddCustomContext("serojump_target", "native");
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
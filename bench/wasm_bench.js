@@ -0,0 +1,348 @@
+#!/usr/bin/env node
+// Headless WebAssembly counterpart of serojump_bench. Runs the same
+// benchmarks (same names and arguments) through the C exports the widget
+// uses, and prints Google Benchmark's console table or writes its JSON, so
+// native and WASM throughput compare directly:
+//
+//   emcmake cmake -S . -B build-wasm -DCMAKE_BUILD_TYPE=Release
+//   cmake --build build-wasm --target serojump_bench_module
+//   node bench/wasm_bench.js build-wasm/bench/serojump_bench_module.js \
+//        [--filter REGEX] [--min-time SECONDS] [--out wasm.json]
+//   compare.py benchmarks native.json wasm.json
+//
+// The per-sample titre benchmark calls compute_titre once per sample from
+// JavaScript, as the widget's plotting code does, so it includes the JS to
+// WASM call overhead; the others make one call per iteration.
+
+'use strict';
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+// Same study and antibody parameters as bench/serojump_bench.cpp
+const STUDY = { start: 0.0, end: 12.0, infectionRate: 0.3 };
+const ANTIBODY = { baselineMean: 2.0, baselineSD: 0.3, boostMean: 2.0, boostSD: 0.2, decayRate: 0.1, observationSD: 0.2 };
+
+function parseArguments(argv) {
+    const options = { modulePath: null, filter: null, minTime: 0.5, out: null };
+    for (let i = 0; i < argv.length; i++) {
+        const arg = argv[i];
+        if (arg === '--filter' && i + 1 < argv.length) {
+            options.filter = new RegExp(argv[++i]);
+        } else if (arg === '--min-time' && i + 1 < argv.length) {
+            options.minTime = Number(argv[++i]);
+        } else if (arg === '--out' && i + 1 < argv.length) {
+            options.out = argv[++i];
+        } else if (!options.modulePath && !arg.startsWith('--')) {
+            options.modulePath = path.resolve(arg);
+        } else {
+            return null;
+        }
+    }
+    return options.modulePath && options.minTime > 0 ? options : null;
+}
+
+// Every argument combination of a benchmark family, like ArgsProduct
+function argsProduct(lists) {
+    return lists.reduce((combinations, list) =>
+        combinations.flatMap(prefix => list.map(value => prefix.concat([value]))), [[]]);
+}
+
+function range(low, high, multiplier) {
+    const values = [];
+    for (let value = low; value < high; value *= multiplier) values.push(value);
+    values.push(high);
+    return values;
+}
+
+class Bench {
+    constructor(Module) {
+        this.Module = Module;
+        this.allocations = [];
+        const wrap = (name, result, count) => Module.cwrap(name, result, new Array(count).fill('number'));
+        this.computeTitre = wrap('compute_titre', 'number', 5);
+        this.computeLogLikelihood = wrap('compute_log_likelihood', 'number', 10);
+        this.mcmcStepIndividual = wrap('mcmc_step_individual', 'number', 28);
+        this.simulateStudyExport = wrap('simulate_study', 'number', 18);
+        this.createStudyStream = wrap('create_study_stream', 'number', 13);
+        this.studyStreamNext = wrap('study_stream_next', 'number', 7);
+        this.destroyStudyStream = wrap('destroy_study_stream', null, 1);
+        this.createCohortHandle = wrap('create_cohort_handle', 'number', 6);
+        this.cohortSetModel = wrap('cohort_set_model', 'number', 14);
+        this.cohortStepIndividual = wrap('cohort_step_individual', 'number', 3);
+        this.destroyCohortHandle = wrap('destroy_cohort_handle', null, 1);
+        this.runMCMCStudySummary = wrap('run_mcmc_study_summary', 'number', 33);
+        this.simulator = Module.ccall('create_serojump_simulator', 'number', ['number'], [12345]);
+    }
+
+    alloc(bytes) {
+        const ptr = this.Module._malloc(bytes);
+        this.allocations.push(ptr);
+        return ptr;
+    }
+
+    // Free everything allocated while setting up one benchmark
+    release() {
+        this.allocations.forEach(ptr => this.Module._free(ptr));
+        this.allocations = [];
+        if (this.handle) this.destroyCohortHandle(this.handle);
+        this.handle = 0;
+    }
+
+    simulateInto(nIndividuals, nSamples, infectionRate) {
+        const total = nIndividuals * nSamples;
+        const cohort = {
+            ids: this.alloc(total * 4), sampleTimes: this.alloc(total * 8), titreValues: this.alloc(total * 8),
+            trueInfectionTimes: this.alloc(nIndividuals * 8), status: this.alloc(nIndividuals * 4),
+            totalSamples: this.alloc(4)
+        };
+        this.simulateStudyExport(this.simulator, STUDY.start, STUDY.end, nIndividuals, infectionRate, nSamples,
+            ANTIBODY.baselineMean, ANTIBODY.baselineSD, ANTIBODY.boostMean, ANTIBODY.boostSD,
+            ANTIBODY.decayRate, ANTIBODY.observationSD,
+            cohort.ids, cohort.sampleTimes, cohort.titreValues, cohort.trueInfectionTimes, cohort.status,
+            cohort.totalSamples);
+        return cohort;
+    }
+
+    // Every individual infected, so the likelihood takes the post-infection path
+    benchCohort(nIndividuals, nSamples) {
+        return this.simulateInto(nIndividuals, nSamples, 0.999);
+    }
+
+    firstInfectionTime(cohort) {
+        return this.Module.HEAPF64[cohort.trueInfectionTimes / 8];
+    }
+}
+
+// One chain stepped through a registered cohort handle (BM_CohortStep*)
+function cohortStepSetup(bench, nSamples, timeGrid) {
+    const cohort = bench.benchCohort(1, nSamples);
+    const nSamplesPtr = bench.alloc(4);
+    bench.Module.HEAP32[nSamplesPtr / 4] = nSamples;
+    bench.handle = bench.createCohortHandle(bench.simulator, 1, cohort.ids, cohort.sampleTimes,
+        cohort.titreValues, nSamplesPtr);
+    bench.cohortSetModel(bench.handle, STUDY.start, STUDY.end, STUDY.infectionRate, 1,
+        ANTIBODY.baselineMean, ANTIBODY.baselineSD, ANTIBODY.boostMean, ANTIBODY.boostSD,
+        ANTIBODY.decayRate, ANTIBODY.observationSD, 0, 0, timeGrid);
+    const run = () => bench.cohortStepIndividual(bench.handle, 0, 1);
+    return { run, items: 1 };
+}
+
+// Each family returns a per-run closure (after setup) and the items one call processes
+const FAMILIES = [
+    {
+        name: 'BM_ComputeTitre', argNames: ['samples'], args: argsProduct([range(4, 1024, 4)]),
+        counter: 'ns_per_sample',
+        setup(bench, [nSamples]) {
+            const cohort = bench.benchCohort(1, nSamples);
+            const times = bench.Module.HEAPF64.slice(cohort.sampleTimes / 8, cohort.sampleTimes / 8 + nSamples);
+            const infectionTime = bench.firstInfectionTime(cohort);
+            const run = () => {
+                let sum = 0;
+                for (let k = 0; k < nSamples; k++) {
+                    sum += bench.computeTitre(2.0, 2.0, 0.1, infectionTime, times[k]);
+                }
+                return sum;
+            };
+            return { run, items: nSamples };
+        }
+    },
+    {
+        name: 'BM_LogLikelihood', argNames: ['samples'], args: argsProduct([range(4, 1024, 4)]),
+        counter: 'ns_per_sample',
+        setup(bench, [nSamples]) {
+            const cohort = bench.benchCohort(1, nSamples);
+            const infectionTime = bench.firstInfectionTime(cohort);
+            const run = () => bench.computeLogLikelihood(1, cohort.sampleTimes, cohort.titreValues, nSamples,
+                ANTIBODY.baselineMean, ANTIBODY.boostMean, ANTIBODY.decayRate, infectionTime, 1,
+                ANTIBODY.observationSD);
+            return { run, items: nSamples };
+        }
+    },
+    {
+        // One step of a single chain, which carries on from step to step
+        name: 'BM_MCMCStepIndividual', argNames: ['samples'], args: argsProduct([range(4, 1024, 4)]),
+        counter: 'ns_per_step',
+        setup(bench, [nSamples]) {
+            const cohort = bench.benchCohort(1, nSamples);
+            const out = bench.alloc(64);
+            const heapF64 = () => bench.Module.HEAPF64;
+            const heap32 = () => bench.Module.HEAP32;
+            const state = { baseline: ANTIBODY.baselineMean, boost: ANTIBODY.boostMean,
+                            infectionTime: bench.firstInfectionTime(cohort), infected: 1, logLikelihood: NaN };
+            const run = () => {
+                bench.mcmcStepIndividual(bench.simulator, 1, cohort.sampleTimes, cohort.titreValues, nSamples,
+                    state.baseline, state.boost, state.infectionTime, state.infected, state.logLikelihood,
+                    STUDY.start, STUDY.end, STUDY.infectionRate,
+                    ANTIBODY.baselineMean, ANTIBODY.baselineSD, ANTIBODY.boostMean, ANTIBODY.boostSD,
+                    ANTIBODY.decayRate, ANTIBODY.observationSD, 0, 0,
+                    out, out + 8, out + 16, out + 24, out + 32, out + 40, out + 48);
+                const doubles = heapF64();
+                state.baseline = doubles[out / 8];
+                state.boost = doubles[out / 8 + 1];
+                state.infectionTime = doubles[out / 8 + 2];
+                state.infected = heap32()[(out + 24) / 4];
+                state.logLikelihood = doubles[out / 8 + 4];
+            };
+            return { run, items: 1 };
+        }
+    },
+    {
+        // The same single-chain step through a registered cohort handle
+        name: 'BM_CohortStep', argNames: ['samples'], args: argsProduct([range(4, 1024, 4)]),
+        counter: 'ns_per_step',
+        setup: (bench, [nSamples]) => cohortStepSetup(bench, nSamples, 0)
+    },
+    {
+        // Infection-time moves from the grid proposal
+        name: 'BM_CohortStepGrid', argNames: ['samples', 'cells'], args: argsProduct([[16, 256], [64, 512]]),
+        counter: 'ns_per_step',
+        setup: (bench, [nSamples, cells]) => cohortStepSetup(bench, nSamples, cells)
+    },
+    {
+        name: 'BM_SimulateStudy', argNames: ['individuals', 'samples'],
+        args: argsProduct([[100, 1000, 10000], [5, 20]]), counter: 'ns_per_sample',
+        setup(bench, [nIndividuals, nSamples]) {
+            const total = nIndividuals * nSamples;
+            const buffers = {
+                ids: bench.alloc(total * 4), sampleTimes: bench.alloc(total * 8), titreValues: bench.alloc(total * 8),
+                trueInfectionTimes: bench.alloc(nIndividuals * 8), status: bench.alloc(nIndividuals * 4),
+                totalSamples: bench.alloc(4)
+            };
+            const run = () => bench.simulateStudyExport(bench.simulator, STUDY.start, STUDY.end, nIndividuals,
+                STUDY.infectionRate, nSamples,
+                ANTIBODY.baselineMean, ANTIBODY.baselineSD, ANTIBODY.boostMean, ANTIBODY.boostSD,
+                ANTIBODY.decayRate, ANTIBODY.observationSD,
+                buffers.ids, buffers.sampleTimes, buffers.titreValues, buffers.trueInfectionTimes,
+                buffers.status, buffers.totalSamples);
+            return { run, items: total };
+        }
+    },
+    {
+        // Large cohorts streamed through study_stream_next in chunks of 4096
+        name: 'BM_SimulateStudyStream', argNames: ['individuals', 'samples'],
+        args: argsProduct([[100000, 1000000], [5]]), counter: 'ns_per_sample', unit: 'ms',
+        setup(bench, [nIndividuals, nSamples]) {
+            const chunkSize = 4096;
+            const total = chunkSize * nSamples;
+            const buffers = {
+                ids: bench.alloc(total * 4), sampleTimes: bench.alloc(total * 8), titreValues: bench.alloc(total * 8),
+                trueInfectionTimes: bench.alloc(chunkSize * 8), status: bench.alloc(chunkSize * 4),
+                totalSamples: bench.alloc(4)
+            };
+            const run = () => {
+                const stream = bench.createStudyStream(bench.simulator, STUDY.start, STUDY.end, nIndividuals,
+                    STUDY.infectionRate, nSamples,
+                    ANTIBODY.baselineMean, ANTIBODY.baselineSD, ANTIBODY.boostMean, ANTIBODY.boostSD,
+                    ANTIBODY.decayRate, ANTIBODY.observationSD, chunkSize);
+                while (bench.studyStreamNext(stream, buffers.ids, buffers.sampleTimes, buffers.titreValues,
+                    buffers.trueInfectionTimes, buffers.status, buffers.totalSamples) > 0) {}
+                bench.destroyStudyStream(stream);
+            };
+            return { run, items: nIndividuals * nSamples };
+        }
+    },
+    {
+        // The full study sweep on one chain and one thread, half the steps burn-in
+        name: 'BM_StudySweep', argNames: ['individuals', 'samples', 'steps'],
+        args: argsProduct([[100, 1000], [5, 20], [1000]]), counter: 'ns_per_step', unit: 'ms',
+        setup(bench, [nIndividuals, nSamples, nSteps]) {
+            const cohort = bench.benchCohort(nIndividuals, nSamples);
+            const firstIds = bench.alloc(nIndividuals * 4);
+            const nSamplesPtr = bench.alloc(nIndividuals * 4);
+            for (let i = 0; i < nIndividuals; i++) {
+                bench.Module.HEAP32[firstIds / 4 + i] = i + 1;
+                bench.Module.HEAP32[nSamplesPtr / 4 + i] = nSamples;
+            }
+            const nBins = 40;
+            const perIndividual = () => bench.alloc(nIndividuals * 8);
+            const outputs = [perIndividual(), perIndividual(), perIndividual(), perIndividual(), perIndividual(),
+                             perIndividual(), perIndividual(), bench.alloc(nIndividuals * 24),
+                             bench.alloc(nIndividuals * nBins * 4), perIndividual(), bench.alloc(nIndividuals * 24)];
+            const run = () => bench.runMCMCStudySummary(bench.simulator, nIndividuals, firstIds,
+                cohort.sampleTimes, cohort.titreValues, nSamplesPtr,
+                nSteps, nSteps / 2, 1, 1, 1, 1,
+                STUDY.start, STUDY.end, STUDY.infectionRate,
+                ANTIBODY.baselineMean, ANTIBODY.baselineSD, ANTIBODY.boostMean, ANTIBODY.boostSD,
+                ANTIBODY.decayRate, ANTIBODY.observationSD, nBins, ...outputs);
+            return { run, items: nIndividuals * nSteps };
+        }
+    }
+];
+
+const UNIT_SCALE = { ns: 1, ms: 1e-6 };
+
+// Google Benchmark's iteration policy: grow the count until a run takes min_time
+function measure(run, minTime) {
+    let iterations = 1;
+    while (true) {
+        const start = process.hrtime.bigint();
+        for (let i = 0; i < iterations; i++) run();
+        const seconds = Number(process.hrtime.bigint() - start) * 1e-9;
+        if (seconds >= minTime || iterations >= 1e9) return { iterations, seconds };
+        const multiplier = seconds > 0 ? Math.min(10, minTime * 1.4 / seconds) : 10;
+        iterations = Math.max(iterations + 1, Math.round(iterations * multiplier));
+    }
+}
+
+function main() {
+    const options = parseArguments(process.argv.slice(2));
+    if (!options) {
+        console.error('Usage: node wasm_bench.js <serojump_bench_module.js> [--filter REGEX] ' +
+                      '[--min-time SECONDS] [--out FILE.json]');
+        process.exit(1);
+    }
+
+    const createSeroJumpModule = require(options.modulePath);
+    createSeroJumpModule().then(Module => {
+        const bench = new Bench(Module);
+        const context = {
+            date: new Date().toISOString(),
+            host_name: os.hostname(),
+            executable: options.modulePath,
+            num_cpus: os.cpus().length,
+            library_build_type: 'release',
+            serojump_target: 'wasm',
+            node_version: process.version
+        };
+        const results = [];
+        console.log('Benchmark'.padEnd(52) + 'Time'.padStart(16) + 'Iterations'.padStart(14) + '  UserCounters...');
+
+        FAMILIES.forEach((family, familyIndex) => {
+            family.args.forEach((args, instanceIndex) => {
+                const name = family.name + '/' +
+                    args.map((value, k) => family.argNames[k] + ':' + value).join('/');
+                if (options.filter && !options.filter.test(name)) return;
+
+                const { run, items } = family.setup(bench, args);
+                const { iterations, seconds } = measure(run, options.minTime);
+                bench.release();
+
+                const unit = family.unit || 'ns';
+                const time = seconds * 1e9 / iterations * UNIT_SCALE[unit];
+                const itemsPerSecond = items * iterations / seconds;
+                results.push({
+                    name, family_index: familyIndex, per_family_instance_index: instanceIndex,
+                    run_name: name, run_type: 'iteration', repetitions: 1, repetition_index: 0, threads: 1,
+                    iterations, real_time: time, cpu_time: time, time_unit: unit,
+                    items_per_second: itemsPerSecond, [family.counter]: 1e9 / itemsPerSecond
+                });
+                console.log(name.padEnd(52) + (time.toPrecision(4) + ' ' + unit).padStart(16) +
+                            String(iterations).padStart(14) +
+                            `  items_per_second=${(itemsPerSecond / 1e6).toPrecision(4)}M/s ` +
+                            `${family.counter}=${(1e9 / itemsPerSecond).toPrecision(4)}`);
+            });
+        });
+
+        Module.ccall('destroy_serojump_simulator', null, ['number'], [bench.simulator]);
+        if (options.out) {
+            fs.writeFileSync(options.out, JSON.stringify({ context, benchmarks: results }, null, 2));
+        }
+    }).catch(error => {
+        console.error('❌ ' + error.message);
+        process.exit(1);
+    });
+}
+
+main();
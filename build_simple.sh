@@ -19,12 +19,21 @@ fi
 # Build native server first using direct g++
 echo -e "${BLUE}🚀 Building native C++ server...${NC}"
 
-if g++ -std=c++17 -O2 -pthread -o build/serojump_server src/server.cpp; then
+# Precompressed static assets when zlib / brotli are installed
+SERVER_FLAGS=""
+if [ -f /usr/include/zlib.h ]; then
+    SERVER_FLAGS="$SERVER_FLAGS -DSEROJUMP_HAVE_ZLIB -lz"
+fi
+if [ -f /usr/include/brotli/encode.h ]; then
+    SERVER_FLAGS="$SERVER_FLAGS -DSEROJUMP_HAVE_BROTLI -lbrotlienc"
+fi
+
+if g++ -std=c++17 -O2 -pthread -o build/serojump_server src/server.cpp src/compute_api.cpp src/serojump.cpp $SERVER_FLAGS; then
     echo -e "${GREEN}✅ Native server built successfully!${NC}"
 else
     echo -e "${RED}❌ Failed to build native server${NC}"
     echo "Trying with clang++..."
-    if clang++ -std=c++17 -O2 -pthread -o build/serojump_server src/server.cpp; then
+    if clang++ -std=c++17 -O2 -pthread -o build/serojump_server src/server.cpp src/compute_api.cpp src/serojump.cpp $SERVER_FLAGS; then
         echo -e "${GREEN}✅ Native server built successfully with clang++!${NC}"
     else
         echo -e "${RED}❌ Failed to build native server with both g++ and clang++${NC}"
@@ -40,10 +49,11 @@ if command -v emcc &> /dev/null; then
     mkdir -p build/web
     
     # Build with Emscripten
-    if emcc -std=c++17 -O2 \
+    if emcc -std=c++17 -O2 -msimd128 \
         -s WASM=1 \
-        -s 'EXPORTED_RUNTIME_METHODS=["ccall","cwrap"]' \
-        -s 'EXPORTED_FUNCTIONS=["_malloc","_free"]' \
+        -s 'EXPORTED_RUNTIME_METHODS=["ccall","cwrap","HEAP32","HEAPF64"]' \
+        -s 'EXPORTED_FUNCTIONS=["_malloc","_free","_create_serojump_simulator","_destroy_serojump_simulator","_simulate_study","_create_study_stream","_study_stream_next","_destroy_study_stream","_mcmc_step_individual","_create_cohort_handle","_cohort_set_model","_cohort_set_infection_hazard","_cohort_set_hierarchical","_cohort_step","_cohort_step_individual","_cohort_array","_destroy_cohort_handle","_run_mcmc_study","_run_mcmc_study_parallel","_run_mcmc_study_summary","_run_mcmc_study_until_converged","_compute_titre","_compute_log_likelihood"]' \
+        -s ENVIRONMENT=web,worker \
         -s ALLOW_MEMORY_GROWTH=1 \
         -s NO_EXIT_RUNTIME=1 \
         -s MODULARIZE=1 \
@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Log lines handed from the I/O threads to one writer thread through a
+// bounded lock-free ring (Vyukov's multi-producer queue), so a request never
+// waits on stdout. When the writer falls kSlots lines behind, further lines
+// are dropped and counted rather than blocking. Lines longer than kLineSize
+// are truncated.
+class AsyncLog {
+public:
+    static constexpr size_t kSlots = 4096;          // power of two
+    static constexpr size_t kLineSize = 240;
+
+    AsyncLog() : slots(new Slot[kSlots]) {
+        for (size_t i = 0; i < kSlots; i++) slots[i].sequence.store(i, std::memory_order_relaxed);
+        writer = std::thread([this]() { run(); });
+    }
+
+    ~AsyncLog() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        writer.join();
+    }
+
+    AsyncLog(const AsyncLog&) = delete;
+    AsyncLog& operator=(const AsyncLog&) = delete;
+
+    // printf-style; a newline is appended
+    void printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        size_t position = head.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots[position & (kSlots - 1)];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t difference = intptr_t(sequence) - intptr_t(position);
+            if (difference == 0) {
+                if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+            } else if (difference < 0) {
+                dropped_lines.fetch_add(1, std::memory_order_relaxed);
+                return;
+            } else {
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
+
+        va_list arguments;
+        va_start(arguments, format);
+        int length = std::vsnprintf(slot->text, kLineSize, format, arguments);
+        va_end(arguments);
+        slot->length = length < 0 ? 0 : size_t(length) < kLineSize ? size_t(length) : kLineSize - 1;
+        slot->sequence.store(position + 1, std::memory_order_release);
+    }
+
+    uint64_t dropped() const { return dropped_lines.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        size_t length = 0;
+        char text[kLineSize];
+    };
+
+    // Drain everything published so far into one write
+    bool drain(std::string& batch) {
+        batch.clear();
+        while (true) {
+            Slot& slot = slots[tail & (kSlots - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != tail + 1) break;
+            batch.append(slot.text, slot.length);
+            batch += '\n';
+            slot.sequence.store(tail + kSlots, std::memory_order_release);
+            tail++;
+        }
+        if (batch.empty()) return false;
+        std::fwrite(batch.data(), 1, batch.size(), stdout);
+        std::fflush(stdout);
+        return true;
+    }
+
+    // Producers never signal; the writer polls every few milliseconds
+    void run() {
+        std::string batch;
+        while (true) {
+            if (drain(batch)) continue;
+            std::unique_lock<std::mutex> lock(mutex);
+            if (stopping) break;
+            wake.wait_for(lock, std::chrono::milliseconds(10));
+        }
+        drain(batch);
+    }
+
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) size_t tail = 0;                     // writer thread only
+    std::atomic<uint64_t> dropped_lines{0};
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread writer;
+};
@@ -0,0 +1,346 @@
+#include "compute_api.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <limits>
+
+namespace {
+
+// Read an integer field within [low, high]
+bool readInt(const FlatJson& json, const char* key, int fallback, int low, int high,
+             int& out, std::string& error) {
+    double value = json.number(key, fallback);
+    if (value != std::floor(value) || value < low || value > high) {
+        error = std::string("\"") + key + "\" must be an integer in [" +
+                std::to_string(low) + ", " + std::to_string(high) + "]";
+        return false;
+    }
+    out = int(value);
+    return true;
+}
+
+bool readPositive(const FlatJson& json, const char* key, double fallback, double& out, std::string& error) {
+    out = json.number(key, fallback);
+    if (!(out > 0.0)) {
+        error = std::string("\"") + key + "\" must be positive";
+        return false;
+    }
+    return true;
+}
+
+// Study window, infection rate and antibody kinetics shared by both endpoints
+bool readModelParams(const FlatJson& json, double default_start, double default_end,
+                     StudyParams& study_params, AntibodyParams& ab_params, std::string& error) {
+    study_params.study_start = json.number("study_start", default_start);
+    study_params.study_end = json.number("study_end", default_end);
+    if (!(study_params.study_end > study_params.study_start)) {
+        error = "\"study_end\" must be after \"study_start\"";
+        return false;
+    }
+    study_params.infection_rate = json.number("infection_rate", 0.3);
+    if (!(study_params.infection_rate > 0.0 && study_params.infection_rate < 1.0)) {
+        error = "\"infection_rate\" must be in (0, 1)";
+        return false;
+    }
+    if (!readInt(json, "max_infections", 1, 1, 16, study_params.max_infections, error)) return false;
+    if (const std::vector<double>* hazard = json.array("infection_hazard")) {
+        if (hazard->size() > 4096 || !InfectionHazard::valid(*hazard)) {
+            error = "\"infection_hazard\" must be at most 4096 non-negative values with a positive sum";
+            return false;
+        }
+        study_params.infection_hazard = InfectionHazard(*hazard);
+    }
+
+    ab_params.baseline_mean = json.number("baseline_mean", 2.0);
+    ab_params.boost_mean = json.number("boost_mean", 2.0);
+    ab_params.decay_rate = json.number("decay_rate", 0.0);
+    if (ab_params.decay_rate < 0.0) {
+        error = "\"decay_rate\" must not be negative";
+        return false;
+    }
+    return readPositive(json, "baseline_sd", 0.3, ab_params.baseline_sd, error) &&
+           readPositive(json, "boost_sd", 0.2, ab_params.boost_sd, error) &&
+           readPositive(json, "observation_sd", 0.2, ab_params.observation_sd, error);
+}
+
+unsigned readSeed(const FlatJson& json) {
+    return unsigned(std::fmod(std::fabs(json.number("seed", 12345.0)), 4294967296.0));
+}
+
+// Append fields to a cache key; doubles round-trip exactly at %.17g
+void appendKey(std::string& key, double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "|%.17g", value);
+    key += text;
+}
+
+void appendModelParams(std::string& key, const StudyParams& study_params, const AntibodyParams& ab_params) {
+    for (double value : { study_params.study_start, study_params.study_end, study_params.infection_rate,
+                          double(study_params.max_infections), double(study_params.n_individuals),
+                          ab_params.baseline_mean, ab_params.baseline_sd, ab_params.boost_mean,
+                          ab_params.boost_sd, ab_params.decay_rate, ab_params.observation_sd }) {
+        appendKey(key, value);
+    }
+    const std::vector<double>& hazard = study_params.infection_hazard.values();
+    appendKey(key, double(hazard.size()));
+    for (double value : hazard) appendKey(key, value);
+}
+
+template <typename T>
+uint64_t hashVector(const std::vector<T>& values, uint64_t hash) {
+    uint64_t size = values.size();
+    hash = fnv1a64(&size, sizeof(size), hash);
+    return fnv1a64(values.data(), values.size() * sizeof(T), hash);
+}
+
+// A cached result instead of the computation, if the spill directory has one
+bool postSpilledResult(ResultCache* cache, const std::string& key, JobChannel& channel) {
+    std::string result;
+    if (!cache || !cache->getSpilled(key, result)) return false;
+    channel.post(sseEvent("result", result), true);
+    return true;
+}
+
+void postResult(ResultCache* cache, const std::string& key, JobChannel& channel, const std::string& result) {
+    if (cache) cache->put(key, result);
+    channel.post(sseEvent("result", result), true);
+}
+
+} // namespace
+
+std::string resultCacheKey(const SimulateRequest& request) {
+    std::string key = "simulate";
+    appendKey(key, request.seed);
+    appendKey(key, request.n_samples_per_individual);
+    appendModelParams(key, request.study_params, request.ab_params);
+    return key;
+}
+
+std::string resultCacheKey(const FitRequest& request) {
+    std::string key = "fit";
+    for (double value : { double(request.seed), double(request.max_steps), double(request.burnin),
+                          double(request.thin), double(request.n_chains), double(request.n_bins),
+                          double(request.options.check_interval), request.options.max_rhat,
+                          request.options.min_ess,
+                          double(request.options.stop_when_converged),
+                          double(request.study_params.gibbs_parameters),
+                          double(request.study_params.time_grid) }) {
+        appendKey(key, value);
+    }
+    appendModelParams(key, request.study_params, request.ab_params);
+
+    const Cohort& cohort = request.cohort;
+    uint64_t hash = hashVector(cohort.ids, 1469598103934665603ULL);
+    hash = hashVector(cohort.offsets, hash);
+    hash = hashVector(cohort.sample_times, hash);
+    hash = hashVector(cohort.titre_values, hash);
+    char text[24];
+    std::snprintf(text, sizeof(text), "|%016llx", (unsigned long long)hash);
+    return key + text;
+}
+
+bool parseSimulateRequest(const FlatJson& json, const ComputeLimits& limits,
+                          SimulateRequest& request, std::string& error) {
+    request.seed = readSeed(json);
+    request.n_threads = limits.n_threads;
+    return readInt(json, "n_individuals", 100, 1, limits.max_individuals,
+                   request.study_params.n_individuals, error) &&
+           readInt(json, "n_samples_per_individual", 5, 1, limits.max_samples_per_individual,
+                   request.n_samples_per_individual, error) &&
+           readModelParams(json, 0.0, 12.0, request.study_params, request.ab_params, error);
+}
+
+bool parseFitRequest(const FlatJson& json, const ComputeLimits& limits,
+                     FitRequest& request, std::string& error) {
+    const std::vector<double>* ids = json.array("ids");
+    const std::vector<double>* n_samples = json.array("n_samples");
+    const std::vector<double>* sample_times = json.array("sample_times");
+    const std::vector<double>* titre_values = json.array("titre_values");
+    if (!ids || !n_samples || !sample_times || !titre_values) {
+        error = "\"ids\", \"n_samples\", \"sample_times\" and \"titre_values\" are required";
+        return false;
+    }
+    int n_individuals = int(ids->size());
+    if (n_individuals == 0 || n_individuals > limits.max_individuals || n_samples->size() != ids->size() ||
+        sample_times->size() != titre_values->size()) {
+        error = "cohort arrays have inconsistent lengths";
+        return false;
+    }
+
+    // Rebuild the flat cohort, checking every individual's samples are in time order
+    Cohort& cohort = request.cohort;
+    cohort.reserve(n_individuals, int(sample_times->size()));
+    size_t offset = 0;
+    double earliest = std::numeric_limits<double>::infinity();
+    double latest = -earliest;
+    for (int i = 0; i < n_individuals; i++) {
+        double id = (*ids)[i];
+        if (id != std::floor(id) || id < std::numeric_limits<int>::min() || id > std::numeric_limits<int>::max()) {
+            error = "\"ids\" must be integers in [" + std::to_string(std::numeric_limits<int>::min()) + ", " +
+                    std::to_string(std::numeric_limits<int>::max()) + "]";
+            return false;
+        }
+        double count = (*n_samples)[i];
+        if (count != std::floor(count) || count < 1 || count > limits.max_samples_per_individual ||
+            offset + size_t(count) > sample_times->size()) {
+            error = "\"n_samples\" does not match \"sample_times\"";
+            return false;
+        }
+        for (size_t k = offset; k < offset + size_t(count); k++) {
+            double t = (*sample_times)[k];
+            if (k > offset && t < (*sample_times)[k - 1]) {
+                error = "sample times of individual " + std::to_string(i) + " are not ascending";
+                return false;
+            }
+            earliest = std::min(earliest, t);
+            latest = std::max(latest, t);
+            cohort.sample_times.push_back(t);
+            cohort.titre_values.push_back((*titre_values)[k]);
+        }
+        offset += size_t(count);
+        cohort.ids.push_back(int(id));
+        cohort.offsets.push_back(int(offset));
+    }
+    if (offset != sample_times->size()) {
+        error = "\"n_samples\" does not match \"sample_times\"";
+        return false;
+    }
+
+    request.seed = readSeed(json);
+    request.options.max_rhat = json.number("max_rhat", request.options.max_rhat);
+    request.options.min_ess = json.number("min_ess", request.options.min_ess);
+    request.options.stop_when_converged = json.number("stop_when_converged", 1.0) != 0.0;
+    request.study_params.gibbs_parameters = json.number("gibbs", 0.0) != 0.0;
+    request.n_threads = limits.n_threads;
+    if (!readInt(json, "max_steps", 10000, 1, limits.max_steps, request.max_steps, error) ||
+        !readInt(json, "burnin", std::min(2000, request.max_steps / 2), 0, request.max_steps - 1,
+                 request.burnin, error) ||
+        !readInt(json, "thin", 1, 1, request.max_steps, request.thin, error) ||
+        !readInt(json, "n_chains", 4, 2, limits.max_chains, request.n_chains, error) ||
+        !readInt(json, "n_bins", 40, 1, 1000, request.n_bins, error) ||
+        !readInt(json, "time_grid", 0, 0, 4096, request.study_params.time_grid, error) ||
+        !readInt(json, "check_interval", 500, 1, request.max_steps, request.options.check_interval, error)) {
+        return false;
+    }
+    // The study window defaults to the span of the data
+    if (!readModelParams(json, std::min(0.0, earliest), latest, request.study_params, request.ab_params, error)) {
+        return false;
+    }
+    request.study_params.n_individuals = n_individuals;
+    return true;
+}
+
+std::string sseEvent(const char* name, const std::string& data) {
+    return std::string("event: ") + name + "\ndata: " + data + "\n\n";
+}
+
+void runSimulateJob(const SimulateRequest& request, JobChannel& channel,
+                    ResultCache* cache, const std::string& key) {
+    if (channel.cancelled) {
+        channel.post("", true);
+        return;
+    }
+    if (postSpilledResult(cache, key, channel)) return;
+    try {
+        SeroJumpSimulator simulator(request.seed);
+        Cohort cohort = simulator.simulateStudy(request.study_params, request.ab_params,
+                                                request.n_samples_per_individual, request.n_threads);
+
+        std::vector<int> n_samples(cohort.size());
+        for (int i = 0; i < cohort.size(); i++) n_samples[i] = cohort.numSamples(i);
+        std::vector<int> is_infected(cohort.is_infected.begin(), cohort.is_infected.end());
+
+        JsonWriter json;
+        json.beginObject();
+        json.key("ids").array(cohort.ids.data(), cohort.ids.size());
+        json.key("n_samples").array(n_samples.data(), n_samples.size());
+        json.key("sample_times").array(cohort.sample_times.data(), cohort.sample_times.size());
+        json.key("titre_values").array(cohort.titre_values.data(), cohort.titre_values.size());
+        json.key("true_infection_times").array(cohort.true_infection_times.data(),
+                                               cohort.true_infection_times.size());
+        json.key("is_infected").array(is_infected.data(), is_infected.size());
+        json.key("baseline_titres").array(cohort.baseline_titres.data(), cohort.baseline_titres.size());
+        json.endObject();
+        postResult(cache, key, channel, json.str());
+    } catch (const std::exception& e) {
+        channel.post(sseEvent("error", JsonWriter().value(std::string(e.what())).str()), true);
+    }
+}
+
+void runFitJob(const FitRequest& request, JobChannel& channel,
+               ResultCache* cache, const std::string& key) {
+    if (channel.cancelled) {
+        channel.post("", true);
+        return;
+    }
+    if (postSpilledResult(cache, key, channel)) return;
+    try {
+        const Cohort& cohort = request.cohort;
+        std::vector<IndividualView> individuals;
+        individuals.reserve(cohort.size());
+        for (int i = 0; i < cohort.size(); i++) {
+            individuals.push_back(cohort.individual(i));
+        }
+
+        ConvergenceOptions options = request.options;
+        options.on_check = [&](int steps_run, const ConvergenceReport& report) {
+            JsonWriter progress;
+            progress.beginObject();
+            progress.key("steps_run").value(steps_run);
+            progress.key("max_steps").value(request.max_steps);
+            progress.key("converged").value(report.converged);
+            progress.key("n_laggards").value(int(report.laggards.size()));
+            progress.endObject();
+            channel.post(sseEvent("progress", progress.str()));
+            return !channel.cancelled;
+        };
+
+        SeroJumpSimulator simulator(request.seed);
+        ConvergenceReport report;
+        PosteriorSummary summary = simulator.runMCMCStudySummary(
+            individuals, request.ab_params, request.study_params, request.max_steps, request.burnin,
+            request.thin, request.n_bins, request.n_chains, request.n_threads, options, report);
+        if (channel.cancelled) {
+            channel.post("", true);
+            return;
+        }
+
+        JsonWriter json;
+        json.beginObject();
+        json.key("steps_run").value(report.steps_run);
+        json.key("converged").value(report.converged);
+        double study_diagnostics[4] = { report.total_infections_rhat, report.total_infections_ess,
+                                        report.log_likelihood_rhat, report.log_likelihood_ess };
+        json.key("study_diagnostics").array(study_diagnostics, 4);
+        json.key("individuals").beginArray();
+        for (int i = 0; i < summary.n_individuals; i++) {
+            const IndividualSummary& individual = summary.individuals[i];
+            bool ever_infected = individual.n_infected > 0;
+            double nan = std::nan("");
+            double quantiles[3] = { summary.infectionTimeQuantile(i, 0.025),
+                                    summary.infectionTimeQuantile(i, 0.5),
+                                    summary.infectionTimeQuantile(i, 0.975) };
+            json.beginObject();
+            json.key("id").value(cohort.ids[i]);
+            json.key("baseline_mean").value(individual.baseline.mean);
+            json.key("baseline_sd").value(individual.baseline.sd());
+            json.key("boost_mean").value(ever_infected ? individual.boost.mean : nan);
+            json.key("boost_sd").value(ever_infected ? individual.boost.sd() : nan);
+            json.key("infection_prob").value(individual.infectionProbability());
+            json.key("infection_count_mean").value(individual.infection_count.mean);
+            json.key("infection_time_mean").value(ever_infected ? individual.infection_time.mean : nan);
+            json.key("infection_time_sd").value(ever_infected ? individual.infection_time.sd() : nan);
+            json.key("infection_time_quantiles").array(quantiles, 3);
+            json.key("acceptance_rate").value(summary.acceptance_rates[i]);
+            json.key("baseline_rhat").value(i < int(report.baseline_rhat.size()) ? report.baseline_rhat[i] : nan);
+            json.key("infection_rhat").value(i < int(report.infection_rhat.size()) ? report.infection_rhat[i] : nan);
+            json.endObject();
+        }
+        json.endArray();
+        json.endObject();
+        postResult(cache, key, channel, json.str());
+    } catch (const std::exception& e) {
+        channel.post(sseEvent("error", JsonWriter().value(std::string(e.what())).str()), true);
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "flat_json.hpp"
+#include "job_queue.hpp"
+#include "result_cache.hpp"
+#include "serojump.hpp"
+
+// Native compute endpoints of serojump_server. A request body is one flat
+// JSON object using the C exports' parameter names; it is validated on the
+// event-loop thread, and the work then runs as a JobQueue job that posts
+// Server-Sent Events ("progress", then "result" or "error") to its channel.
+//
+// POST /api/simulate
+//   seed, n_individuals, n_samples_per_individual, study_start, study_end,
+//   infection_rate, max_infections, baseline_mean, baseline_sd, boost_mean,
+//   boost_sd, decay_rate, observation_sd, infection_hazard (optional array of
+//   relative hazards on equal-width intervals of the window; uniform if absent)
+//   result: { ids, n_samples, sample_times, titre_values,
+//             true_infection_times, is_infected, baseline_titres }
+//
+// POST /api/fit
+//   the cohort as ids, n_samples, sample_times, titre_values (the layout
+//   /api/simulate returns), plus seed, max_steps, burnin, thin, n_chains,
+//   max_infections, check_interval, max_rhat, min_ess, stop_when_converged,
+//   gibbs (non-zero: exact baseline / boost draws), time_grid (cells of the
+//   grid infection-time proposal, 0 for the random walk), n_bins and the
+//   study / antibody parameters above
+//   progress: { steps_run, max_steps, converged, n_laggards } per check
+//   result: { steps_run, converged, study_diagnostics, individuals: [...] }
+//
+// Both are deterministic in the validated request, so results are kept in a
+// ResultCache under resultCacheKey(); a repeated request is answered with just
+// the "result" event.
+
+struct ComputeLimits {
+    int max_individuals = 100000;
+    int max_samples_per_individual = 1000;
+    int max_steps = 1000000;
+    int max_chains = 16;
+    int n_threads = 0;               // compute threads per job; 0 = all
+};
+
+struct SimulateRequest {
+    unsigned seed = 12345;
+    int n_samples_per_individual = 5;
+    int n_threads = 0;               // does not change the cohort
+    StudyParams study_params{0.0, 1.0, 0, 0.0, {}};
+    AntibodyParams ab_params{};
+};
+
+struct FitRequest {
+    unsigned seed = 12345;
+    int max_steps = 10000;
+    int burnin = 2000;
+    int thin = 1;
+    int n_chains = 4;
+    int n_bins = 40;
+    int n_threads = 0;               // does not change the result (chains run on keyed streams)
+    ConvergenceOptions options;
+    StudyParams study_params{0.0, 1.0, 0, 0.0, {}};
+    AntibodyParams ab_params{};
+    Cohort cohort;
+};
+
+// Validate a request body; false with a message in error if it is unusable
+bool parseSimulateRequest(const FlatJson& json, const ComputeLimits& limits,
+                          SimulateRequest& request, std::string& error);
+bool parseFitRequest(const FlatJson& json, const ComputeLimits& limits,
+                     FitRequest& request, std::string& error);
+
+// Content address of a validated request: every field the result depends
+// on, with the cohort folded into a hash
+std::string resultCacheKey(const SimulateRequest& request);
+std::string resultCacheKey(const FitRequest& request);
+
+// Job bodies: post events to channel and finish it. A fit checks
+// channel.cancelled at every convergence check and stops early when set.
+// With a cache, the job first looks for key in its spill directory and
+// stores the result it computes (cancelled or failed jobs store nothing).
+void runSimulateJob(const SimulateRequest& request, JobChannel& channel,
+                    ResultCache* cache = nullptr, const std::string& key = "");
+void runFitJob(const FitRequest& request, JobChannel& channel,
+               ResultCache* cache = nullptr, const std::string& key = "");
+
+// One Server-Sent Event
+std::string sseEvent(const char* name, const std::string& data);
@@ -0,0 +1,149 @@
+#pragma once
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <vector>
+#include "posterior_summary.hpp"
+
+// Online convergence diagnostics. Each monitored quantity ("target") keeps,
+// per chain, a bounded list of batch moments: draws are folded into batches of
+// a common size, and when the list is full adjacent batches are merged and the
+// batch size doubles. Split-R-hat and a batch-means effective sample size are
+// computed from the batches at any time, so memory stays O(targets * chains)
+// however long the run.
+//
+// Every chain of a target must receive the same number of draws; each
+// (chain, target) pair may be fed from a different thread.
+class ConvergenceMonitor {
+public:
+    static constexpr int kMaxBatches = 64;
+
+    ConvergenceMonitor() = default;
+    ConvergenceMonitor(int n_chains, int n_targets)
+        : n_chains_(n_chains), n_targets_(n_targets),
+          series_(size_t(n_chains) * n_targets) {}
+
+    int numChains() const { return n_chains_; }
+    int numTargets() const { return n_targets_; }
+
+    void add(int chain, int target, double x) {
+        Series& series = at(chain, target);
+        series.current.add(x);
+        if (series.current.count < series.batch_size) return;
+        series.batches.push_back(series.current);
+        series.current = RunningMoments();
+        if (int(series.batches.size()) == kMaxBatches) {
+            for (int k = 0; k < kMaxBatches / 2; k++) {
+                RunningMoments merged = series.batches[2 * k];
+                merged.merge(series.batches[2 * k + 1]);
+                series.batches[k] = merged;
+            }
+            series.batches.resize(kMaxBatches / 2);
+            series.batch_size *= 2;
+        }
+    }
+
+    // Draws per chain that are part of complete batches
+    int64_t batchedDraws(int target) const {
+        const Series& series = at(0, target);
+        return int64_t(series.batches.size()) * series.batch_size;
+    }
+
+    // Split-R-hat over 2 * n_chains half-chains (Gelman et al., BDA3 11.4).
+    // 1 when every chain is constant at the same value, infinity when chains
+    // are constant at different values, NaN before two batches per chain.
+    double splitRhat(int target) const {
+        int n_batches = int(at(0, target).batches.size());
+        if (n_batches < 2) return std::nan("");
+
+        // First half [0, n/2), second half [n - n/2, n); an odd middle batch is dropped
+        int half = n_batches / 2;
+        RunningMoments half_means;
+        double within = 0.0;
+        double n = 0.0;
+        for (int chain = 0; chain < n_chains_; chain++) {
+            const std::vector<RunningMoments>& batches = at(chain, target).batches;
+            for (int first : {0, n_batches - half}) {
+                RunningMoments moments;
+                for (int k = first; k < first + half; k++) moments.merge(batches[k]);
+                half_means.add(moments.mean);
+                within += moments.variance();
+                n = double(moments.count);
+            }
+        }
+        within /= 2 * n_chains_;
+        double between_over_n = half_means.variance();
+
+        if (within <= 0.0) {
+            return between_over_n <= 0.0 ? 1.0 : std::numeric_limits<double>::infinity();
+        }
+        double pooled = (n - 1.0) / n * within + between_over_n;
+        return std::sqrt(pooled / within);
+    }
+
+    // Effective sample size from batch means pooled across chains:
+    // total draws * marginal variance / (batch size * variance of batch means),
+    // capped at the number of draws. NaN before two batches per chain.
+    double ess(int target) const {
+        int n_batches = int(at(0, target).batches.size());
+        if (n_batches < 2) return std::nan("");
+
+        RunningMoments all;
+        double batch_mean_variance = 0.0;
+        int64_t batch_size = at(0, target).batch_size;
+        for (int chain = 0; chain < n_chains_; chain++) {
+            RunningMoments batch_means;
+            for (const RunningMoments& batch : at(chain, target).batches) {
+                all.merge(batch);
+                batch_means.add(batch.mean);
+            }
+            batch_mean_variance += batch_means.variance();
+        }
+        batch_mean_variance /= n_chains_;
+
+        double total = double(all.count);
+        double asymptotic = batch_size * batch_mean_variance;
+        if (asymptotic <= 0.0) return all.variance() > 0.0 ? 0.0 : total;
+        return std::min(total, total * all.variance() / asymptotic);
+    }
+
+private:
+    struct Series {
+        std::vector<RunningMoments> batches;
+        RunningMoments current;
+        int64_t batch_size = 1;
+    };
+
+    Series& at(int chain, int target) { return series_[size_t(target) * n_chains_ + chain]; }
+    const Series& at(int chain, int target) const { return series_[size_t(target) * n_chains_ + chain]; }
+
+    int n_chains_ = 0;
+    int n_targets_ = 0;
+    std::vector<Series> series_;
+};
+
+// Diagnostics at the end of a monitored run. Per individual: baseline and
+// number of infections; study level: total infections and total
+// log-likelihood summed over the cohort. Targets that miss either threshold
+// are laggards.
+struct ConvergenceReport {
+    int steps_run = 0;
+    bool converged = false;
+    std::vector<double> baseline_rhat, baseline_ess;
+    std::vector<double> infection_rhat, infection_ess;
+    double total_infections_rhat = std::nan(""), total_infections_ess = std::nan("");
+    double log_likelihood_rhat = std::nan(""), log_likelihood_ess = std::nan("");
+    std::vector<int> laggards;       // individual indices
+    bool study_laggard = false;      // a study-level target missed a threshold
+};
+
+// When to check and what counts as converged for a monitored MCMC run
+struct ConvergenceOptions {
+    int check_interval = 500;        // steps between checks (all chains advance together)
+    double max_rhat = 1.01;
+    double min_ess = 400.0;
+    bool stop_when_converged = true; // otherwise run every step and just report
+    // Called at every pause with the steps run so far (the report is only
+    // filled in after burn-in); returning false ends the run there
+    std::function<bool(int steps_run, const ConvergenceReport& report)> on_check;
+};
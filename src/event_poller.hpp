@@ -0,0 +1,139 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+
+// Readiness notification for the HTTP server's event loops: epoll on Linux,
+// poll() on other POSIX systems (macOS development machines). Level
+// triggered; each worker thread owns one poller.
+#if defined(__linux__)
+    #include <sys/epoll.h>
+    #define SEROJUMP_EPOLL 1
+#else
+    #include <poll.h>
+#endif
+
+class EventPoller {
+public:
+    struct Event {
+        int fd;
+        bool readable;
+        bool writable;
+        bool hangup;     // error or peer hang-up
+    };
+
+    EventPoller() {
+#if defined(SEROJUMP_EPOLL)
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+#endif
+    }
+
+    ~EventPoller() {
+#if defined(SEROJUMP_EPOLL)
+        if (epoll_fd >= 0) close(epoll_fd);
+#endif
+    }
+
+    EventPoller(const EventPoller&) = delete;
+    EventPoller& operator=(const EventPoller&) = delete;
+
+    bool valid() const {
+#if defined(SEROJUMP_EPOLL)
+        return epoll_fd >= 0;
+#else
+        return true;
+#endif
+    }
+
+    // exclusive: only one of the pollers sharing fd is woken per event (a
+    // listening socket watched by every worker)
+    bool add(int fd, bool want_write, bool exclusive = false) {
+#if defined(SEROJUMP_EPOLL)
+        epoll_event event = {};
+        event.events = interest(true, want_write);
+    #if defined(EPOLLEXCLUSIVE)
+        if (exclusive) event.events |= EPOLLEXCLUSIVE;
+    #else
+        (void)exclusive;
+    #endif
+        event.data.fd = fd;
+        return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0;
+#else
+        (void)exclusive;
+        index[fd] = fds.size();
+        fds.push_back({ fd, interest(true, want_write), 0 });
+        return true;
+#endif
+    }
+
+    // Errors and hang-ups are reported even with neither read nor write interest
+    bool modify(int fd, bool want_read, bool want_write) {
+#if defined(SEROJUMP_EPOLL)
+        epoll_event event = {};
+        event.events = interest(want_read, want_write);
+        event.data.fd = fd;
+        return epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event) == 0;
+#else
+        auto it = index.find(fd);
+        if (it == index.end()) return false;
+        fds[it->second].events = interest(want_read, want_write);
+        return true;
+#endif
+    }
+
+    void remove(int fd) {
+#if defined(SEROJUMP_EPOLL)
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+#else
+        auto it = index.find(fd);
+        if (it == index.end()) return;
+        size_t slot = it->second;
+        index.erase(it);
+        if (slot != fds.size() - 1) {
+            fds[slot] = fds.back();
+            index[fds[slot].fd] = slot;
+        }
+        fds.pop_back();
+#endif
+    }
+
+    // Wait up to timeout_ms and fill events; returns the number of ready fds
+    // (0 on timeout or EINTR)
+    int wait(std::vector<Event>& events, int timeout_ms) {
+        events.clear();
+#if defined(SEROJUMP_EPOLL)
+        epoll_event ready[kMaxEvents];
+        int n = epoll_wait(epoll_fd, ready, kMaxEvents, timeout_ms);
+        for (int i = 0; i < n; i++) {
+            uint32_t flags = ready[i].events;
+            events.push_back({ ready[i].data.fd, (flags & EPOLLIN) != 0, (flags & EPOLLOUT) != 0,
+                               (flags & (EPOLLERR | EPOLLHUP)) != 0 });
+        }
+#else
+        int n = poll(fds.data(), fds.size(), timeout_ms);
+        for (size_t i = 0; n > 0 && i < fds.size(); i++) {
+            short flags = fds[i].revents;
+            if (flags == 0) continue;
+            events.push_back({ fds[i].fd, (flags & POLLIN) != 0, (flags & POLLOUT) != 0,
+                               (flags & (POLLERR | POLLHUP | POLLNVAL)) != 0 });
+        }
+#endif
+        return int(events.size());
+    }
+
+private:
+#if defined(SEROJUMP_EPOLL)
+    static constexpr int kMaxEvents = 256;
+    static uint32_t interest(bool want_read, bool want_write) {
+        return (want_read ? uint32_t(EPOLLIN) : 0u) | (want_write ? uint32_t(EPOLLOUT) : 0u);
+    }
+    int epoll_fd = -1;
+#else
+    static short interest(bool want_read, bool want_write) {
+        return short((want_read ? POLLIN : 0) | (want_write ? POLLOUT : 0));
+    }
+    std::vector<pollfd> fds;
+    std::unordered_map<int, size_t> index;
+#endif
+};
@@ -0,0 +1,210 @@
+#pragma once
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Minimal JSON for the compute API. Requests are one flat object whose values
+// are numbers, booleans or arrays of numbers (the same flat layout as the C
+// exports); anything else is rejected. Responses are built with JsonWriter.
+class FlatJson {
+public:
+    // Returns false with a message in error on malformed or unsupported input
+    bool parse(std::string_view text, std::string& error) {
+        input = text;
+        position = 0;
+        numbers.clear();
+        arrays.clear();
+
+        if (!consume('{')) return fail(error, "expected a JSON object");
+        if (consume('}')) return finish(error);
+        do {
+            std::string key;
+            if (!parseKey(key)) return fail(error, "expected a quoted key");
+            if (!consume(':')) return fail(error, "expected ':' after \"" + key + "\"");
+            skipSpace();
+            if (peek() == '[') {
+                position++;
+                std::vector<double>& values = arrays[key];
+                values.clear();
+                if (consume(']')) continue;
+                do {
+                    double value;
+                    if (!parseNumber(value)) return fail(error, "\"" + key + "\" must hold numbers only");
+                    values.push_back(value);
+                } while (consume(','));
+                if (!consume(']')) return fail(error, "unterminated array \"" + key + "\"");
+            } else {
+                double value;
+                if (!parseScalar(value)) return fail(error, "unsupported value for \"" + key + "\"");
+                numbers[key] = value;
+            }
+        } while (consume(','));
+        if (!consume('}')) return fail(error, "expected ',' or '}'");
+        return finish(error);
+    }
+
+    bool has(const std::string& key) const { return numbers.count(key) || arrays.count(key); }
+
+    double number(const std::string& key, double fallback) const {
+        auto it = numbers.find(key);
+        return it == numbers.end() ? fallback : it->second;
+    }
+
+    // nullptr when absent
+    const std::vector<double>* array(const std::string& key) const {
+        auto it = arrays.find(key);
+        return it == arrays.end() ? nullptr : &it->second;
+    }
+
+private:
+    bool fail(std::string& error, const std::string& message) {
+        error = message + " at offset " + std::to_string(position);
+        return false;
+    }
+
+    bool finish(std::string& error) {
+        skipSpace();
+        return position == input.size() || fail(error, "trailing characters");
+    }
+
+    void skipSpace() {
+        while (position < input.size() &&
+               (input[position] == ' ' || input[position] == '\t' ||
+                input[position] == '\n' || input[position] == '\r')) {
+            position++;
+        }
+    }
+
+    char peek() const { return position < input.size() ? input[position] : '\0'; }
+
+    bool consume(char c) {
+        skipSpace();
+        if (peek() != c) return false;
+        position++;
+        return true;
+    }
+
+    // Keys are plain ASCII identifiers; escapes are not needed for this API
+    bool parseKey(std::string& key) {
+        if (!consume('"')) return false;
+        size_t end = input.find('"', position);
+        if (end == std::string_view::npos) return false;
+        key.assign(input.substr(position, end - position));
+        if (key.find('\\') != std::string::npos) return false;
+        position = end + 1;
+        return true;
+    }
+
+    bool parseNumber(double& value) {
+        skipSpace();
+        size_t start = position;
+        while (position < input.size() && input[position] != '\0' &&
+               std::strchr("+-0123456789.eE", input[position]) != nullptr) {
+            position++;
+        }
+        if (position == start || position - start > 64) return false;
+        char buffer[72];
+        input.copy(buffer, position - start, start);
+        buffer[position - start] = '\0';
+        char* end = nullptr;
+        value = std::strtod(buffer, &end);
+        return *end == '\0' && std::isfinite(value);
+    }
+
+    bool parseScalar(double& value) {
+        if (input.substr(position, 4) == "true") {
+            position += 4;
+            value = 1.0;
+            return true;
+        }
+        if (input.substr(position, 5) == "false") {
+            position += 5;
+            value = 0.0;
+            return true;
+        }
+        return parseNumber(value);
+    }
+
+    std::string_view input;
+    size_t position = 0;
+    std::unordered_map<std::string, double> numbers;
+    std::unordered_map<std::string, std::vector<double>> arrays;
+};
+
+// Append-only JSON text builder. The caller is responsible for the structure
+// (commas are inserted automatically between members and elements).
+class JsonWriter {
+public:
+    JsonWriter& beginObject() { separate(); text += '{'; first = true; return *this; }
+    JsonWriter& endObject() { text += '}'; first = false; return *this; }
+    JsonWriter& beginArray() { separate(); text += '['; first = true; return *this; }
+    JsonWriter& endArray() { text += ']'; first = false; return *this; }
+
+    JsonWriter& key(const char* name) {
+        separate();
+        text += '"';
+        text += name;
+        text += "\":";
+        first = true;     // the value follows without a comma
+        return *this;
+    }
+
+    // Non-finite values (NaN for "never infected" summaries) become null
+    JsonWriter& value(double x) {
+        separate();
+        if (!std::isfinite(x)) {
+            text += "null";
+        } else {
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%.12g", x);
+            text += buffer;
+        }
+        return *this;
+    }
+
+    JsonWriter& value(int x) { separate(); text += std::to_string(x); return *this; }
+    JsonWriter& value(bool x) { separate(); text += x ? "true" : "false"; return *this; }
+
+    // Strings are escaped for quotes, backslashes and control characters
+    JsonWriter& value(const std::string& s) {
+        separate();
+        text += '"';
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                text += '\\';
+                text += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char buffer[8];
+                std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                text += buffer;
+            } else {
+                text += c;
+            }
+        }
+        text += '"';
+        return *this;
+    }
+
+    template <typename T>
+    JsonWriter& array(const T* values, size_t n) {
+        beginArray();
+        for (size_t i = 0; i < n; i++) value(values[i]);
+        return endArray();
+    }
+
+    const std::string& str() const { return text; }
+
+private:
+    void separate() {
+        if (!first) text += ',';
+        first = false;
+    }
+
+    std::string text;
+    bool first = true;
+};
@@ -0,0 +1,166 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Incremental HTTP/1.x request-head parser. It works in place on a
+// connection's receive buffer: every field is a string_view into that buffer,
+// so nothing is allocated, and the views stay valid until the caller consumes
+// the request's bytes.
+struct HttpRequest {
+    std::string_view method;
+    std::string_view target;
+    std::string_view version;
+    bool keep_alive = true;
+    uint64_t content_length = 0;
+    std::string_view accept_encoding;
+    std::string_view if_none_match;
+    std::string_view range;
+    std::string_view if_range;
+};
+
+enum class HttpParseResult {
+    Incomplete,        // no blank line yet; read more
+    Complete,
+    BadRequest,        // 400
+    HeadTooLarge,      // 431: over the head size or header count limit
+    NotImplemented     // 501: Transfer-Encoding bodies
+};
+
+class HttpRequestParser {
+public:
+    static constexpr size_t kMaxHeaders = 64;
+
+    explicit HttpRequestParser(size_t max_head_) : max_head(max_head_) {}
+
+    // Forget the scan position (after a request has been consumed)
+    void reset() { scanned = 0; }
+
+    // Try to parse a head from data[0, size). On Complete, head_size is the
+    // number of bytes the head occupies (including the blank line). Bytes
+    // already scanned for the end of the head are not scanned again on the
+    // next call, so a head trickling in costs linear time overall.
+    HttpParseResult parse(const char* data, size_t size, HttpRequest& request, size_t& head_size) {
+        size_t end = findHeadEnd(data, size);
+        if (end == 0) return size > max_head ? HttpParseResult::HeadTooLarge : HttpParseResult::Incomplete;
+        if (end > max_head) return HttpParseResult::HeadTooLarge;
+        head_size = end;
+        return parseHead(data, end, request);
+    }
+
+    static bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); i++) {
+            if (lower(a[i]) != lower(b[i])) return false;
+        }
+        return true;
+    }
+
+    static bool containsIgnoreCase(std::string_view text, std::string_view token) {
+        for (size_t i = 0; i + token.size() <= text.size(); i++) {
+            if (equalsIgnoreCase(text.substr(i, token.size()), token)) return true;
+        }
+        return false;
+    }
+
+    static std::string_view trim(std::string_view text) {
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+        return text;
+    }
+
+private:
+    static char lower(char c) { return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c; }
+
+    // Offset just past the blank line ending the head, or 0 if not there yet.
+    // Lines end in CRLF; a bare LF is tolerated.
+    size_t findHeadEnd(const char* data, size_t size) {
+        size_t i = scanned;
+        for (; i < size; i++) {
+            if (data[i] != '\n') continue;
+            if (i + 1 < size && data[i + 1] == '\n') return i + 2;
+            if (i + 2 < size && data[i + 1] == '\r' && data[i + 2] == '\n') return i + 3;
+        }
+        // Re-examine the last two bytes next time: they may start the terminator
+        scanned = size >= 2 ? size - 2 : 0;
+        return 0;
+    }
+
+    // Split off the next line (without its line ending)
+    static bool nextLine(std::string_view& rest, std::string_view& line) {
+        size_t newline = rest.find('\n');
+        if (newline == std::string_view::npos) return false;
+        line = rest.substr(0, newline);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        rest.remove_prefix(newline + 1);
+        return true;
+    }
+
+    static bool parseDigits(std::string_view text, uint64_t& value) {
+        if (text.empty() || text.size() > 18) return false;
+        value = 0;
+        for (char c : text) {
+            if (c < '0' || c > '9') return false;
+            value = value * 10 + uint64_t(c - '0');
+        }
+        return true;
+    }
+
+    HttpParseResult parseHead(const char* data, size_t size, HttpRequest& request) {
+        request = HttpRequest();
+        std::string_view rest(data, size);
+        std::string_view line;
+
+        // Request line: METHOD SP target SP HTTP/x.y
+        if (!nextLine(rest, line)) return HttpParseResult::BadRequest;
+        size_t first_space = line.find(' ');
+        size_t last_space = line.rfind(' ');
+        if (first_space == std::string_view::npos || last_space == first_space) return HttpParseResult::BadRequest;
+        request.method = line.substr(0, first_space);
+        request.target = trim(line.substr(first_space + 1, last_space - first_space - 1));
+        request.version = line.substr(last_space + 1);
+        if (request.method.empty() || request.target.empty() || request.version.substr(0, 5) != "HTTP/") {
+            return HttpParseResult::BadRequest;
+        }
+
+        // HTTP/1.1 connections persist unless told otherwise; 1.0 ones only on request
+        request.keep_alive = request.version == "HTTP/1.1";
+        bool has_length = false;
+        size_t n_headers = 0;
+        while (nextLine(rest, line) && !line.empty()) {
+            if (++n_headers > kMaxHeaders) return HttpParseResult::HeadTooLarge;
+            size_t colon = line.find(':');
+            if (colon == std::string_view::npos || colon == 0) return HttpParseResult::BadRequest;
+            std::string_view name = line.substr(0, colon);
+            std::string_view value = trim(line.substr(colon + 1));
+
+            if (equalsIgnoreCase(name, "connection")) {
+                if (containsIgnoreCase(value, "close")) request.keep_alive = false;
+                if (containsIgnoreCase(value, "keep-alive")) request.keep_alive = true;
+            } else if (equalsIgnoreCase(name, "content-length")) {
+                uint64_t length;
+                // Conflicting lengths are a request-smuggling vector: refuse them
+                if (!parseDigits(value, length) || (has_length && length != request.content_length)) {
+                    return HttpParseResult::BadRequest;
+                }
+                request.content_length = length;
+                has_length = true;
+            } else if (equalsIgnoreCase(name, "transfer-encoding")) {
+                return HttpParseResult::NotImplemented;
+            } else if (equalsIgnoreCase(name, "accept-encoding")) {
+                request.accept_encoding = value;
+            } else if (equalsIgnoreCase(name, "if-none-match")) {
+                request.if_none_match = value;
+            } else if (equalsIgnoreCase(name, "range")) {
+                request.range = value;
+            } else if (equalsIgnoreCase(name, "if-range")) {
+                request.if_range = value;
+            }
+        }
+        return HttpParseResult::Complete;
+    }
+
+    size_t max_head;
+    size_t scanned = 0;
+};
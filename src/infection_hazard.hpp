@@ -0,0 +1,73 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// Relative infection hazard over the study window, piecewise constant on
+// equal-width intervals (an incidence series, say), used as the density of
+// each infection time: f(t) = h(t) / integral of h. Only its shape matters;
+// how many infections there are is still up to infection_rate.
+//
+// The normalised cumulative hazard (the CDF) at the interval edges and the
+// log-density of every interval are tabulated on construction, so f is an
+// O(1) lookup and an inverse-CDF draw one binary search. Positions are kept as
+// fractions of the window, so a table serves any study_start / study_end.
+// An empty hazard is the uniform density.
+class InfectionHazard {
+public:
+    InfectionHazard() = default;
+
+    // hazard must pass valid()
+    explicit InfectionHazard(const std::vector<double>& hazard_) : hazard(hazard_) {
+        int n = int(hazard.size());
+        cdf.assign(n + 1, 0.0);
+        for (int i = 0; i < n; i++) cdf[i + 1] = cdf[i] + hazard[i];
+        double total = cdf[n];
+        for (double& edge : cdf) edge /= total;
+        cdf[n] = 1.0;
+
+        // Density per unit fraction of the window
+        log_density.resize(n);
+        for (int i = 0; i < n; i++) log_density[i] = std::log(hazard[i] * n / total);
+    }
+
+    // Finite, non-negative values with a positive sum (or none at all)
+    static bool valid(const std::vector<double>& hazard) {
+        double total = 0.0;
+        for (double value : hazard) {
+            if (!(value >= 0.0 && std::isfinite(value))) return false;
+            total += value;
+        }
+        return hazard.empty() || (total > 0.0 && std::isfinite(total));
+    }
+
+    bool empty() const { return hazard.empty(); }
+    const std::vector<double>& values() const { return hazard; }
+
+    // log f(t) on [start, end]; -inf outside it or where the hazard is 0
+    double logDensity(double t, double start, double end) const {
+        double duration = end - start;
+        if (empty()) return -std::log(duration);
+        double position = (t - start) / duration;
+        if (!(position >= 0.0 && position <= 1.0)) return -std::numeric_limits<double>::infinity();
+        int n = int(hazard.size());
+        return log_density[std::min(int(position * n), n - 1)] - std::log(duration);
+    }
+
+    // The time at which the CDF reaches u, for u in [0, 1)
+    double sample(double u, double start, double end) const {
+        if (empty()) return u * (end - start) + start;
+        int n = int(hazard.size());
+        // cdf[bin] <= u < cdf[bin + 1], so the interval has positive mass
+        int bin = int(std::upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin()) - 1;
+        bin = std::min(std::max(bin, 0), n - 1);
+        double within = (u - cdf[bin]) / (cdf[bin + 1] - cdf[bin]);
+        return start + (end - start) * (bin + within) / n;
+    }
+
+private:
+    std::vector<double> hazard;
+    std::vector<double> cdf;            // [n + 1], normalised cumulative hazard at interval edges
+    std::vector<double> log_density;    // [n]
+};
@@ -0,0 +1,161 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Self-pipe that wakes an event-loop worker from another thread. Shared by
+// the worker and every job posting to it, so the descriptors outlive both.
+class WakePipe {
+public:
+    WakePipe() {
+        int fds[2];
+        if (pipe(fds) != 0) return;
+        for (int fd : fds) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+        read_fd = fds[0];
+        write_fd = fds[1];
+    }
+
+    ~WakePipe() {
+        if (read_fd >= 0) close(read_fd);
+        if (write_fd >= 0) close(write_fd);
+    }
+
+    WakePipe(const WakePipe&) = delete;
+    WakePipe& operator=(const WakePipe&) = delete;
+
+    bool valid() const { return read_fd >= 0; }
+    int readFd() const { return read_fd; }
+
+    // A full pipe already guarantees a wake-up, so EAGAIN is fine
+    void notify() {
+        char byte = 1;
+        ssize_t written = write(write_fd, &byte, 1);
+        (void)written;
+    }
+
+    void drain() {
+        char buffer[256];
+        while (read(read_fd, buffer, sizeof(buffer)) > 0) {}
+    }
+
+private:
+    int read_fd = -1;
+    int write_fd = -1;
+};
+
+// Output of one running job, handed from the compute thread to the worker
+// that owns the client connection. The job posts text; the worker takes it
+// when woken. cancelled is set by the worker when the client goes away.
+class JobChannel {
+public:
+    explicit JobChannel(std::shared_ptr<WakePipe> wake_) : wake(std::move(wake_)) {}
+
+    void post(const std::string& text, bool last = false) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending += text;
+            finished = finished || last;
+        }
+        wake->notify();
+    }
+
+    // Move out whatever has been posted; returns true once the job has finished
+    bool take(std::string& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        out.swap(pending);
+        pending.clear();
+        return finished;
+    }
+
+    std::atomic<bool> cancelled{false};
+
+private:
+    std::shared_ptr<WakePipe> wake;
+    std::mutex mutex;
+    std::string pending;
+    bool finished = false;
+};
+
+// Bounded FIFO of jobs run by a fixed set of threads. submit() refuses work
+// once capacity jobs are waiting beyond the idle threads about to take them,
+// so a burst of requests is turned away instead of queueing unbounded
+// compute (and capacity 0 still runs a job whenever a thread is free).
+class JobQueue {
+public:
+    JobQueue(int n_threads, size_t capacity_) : capacity(capacity_) {
+        for (int t = 0; t < std::max(1, n_threads); t++) {
+            threads.emplace_back([this]() { run(); });
+        }
+    }
+
+    ~JobQueue() { stop(); }
+
+    // False when the queue is full; otherwise position is the number of jobs
+    // ahead of this one that have not started
+    bool submit(std::function<void()> job, size_t& position) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping || waiting.size() >= capacity + idle) return false;
+            position = waiting.size();
+            waiting.push_back(std::move(job));
+        }
+        ready.notify_one();
+        return true;
+    }
+
+    size_t waitingJobs() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return waiting.size();
+    }
+
+    // Drops jobs that have not started and waits for the running ones
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            waiting.clear();
+        }
+        ready.notify_all();
+        for (std::thread& thread : threads) {
+            if (thread.joinable()) thread.join();
+        }
+        threads.clear();
+    }
+
+private:
+    void run() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                idle++;
+                ready.wait(lock, [this]() { return stopping || !waiting.empty(); });
+                idle--;
+                if (stopping) return;
+                job = std::move(waiting.front());
+                waiting.pop_front();
+            }
+            job();
+        }
+    }
+
+    size_t capacity;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::function<void()>> waiting;
+    size_t idle = 0;    // threads waiting for a job
+    bool stopping = false;
+    std::vector<std::thread> threads;
+};
@@ -0,0 +1,200 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Low-overhead process metrics. Every counter and histogram is split into
+// cache-line-sized shards, one per thread (round-robin once there are more
+// threads than shards), so hot paths do an uncontended relaxed add; a scrape
+// sums the shards. PrometheusText renders them in the Prometheus text format.
+namespace metrics {
+
+constexpr int kShards = 16;
+
+// Shard of the calling thread, assigned on its first use
+inline int shardIndex() {
+    static std::atomic<int> next{0};
+    thread_local int index = next.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return index;
+}
+
+// Monotonic counter; also serves as a gauge when given negative deltas
+class Counter {
+public:
+    void add(int64_t delta = 1) {
+        shards[shardIndex()].value.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    int64_t value() const {
+        int64_t total = 0;
+        for (const Shard& shard : shards) total += shard.value.load(std::memory_order_relaxed);
+        return total;
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<int64_t> value{0};
+    };
+    Shard shards[kShards];
+};
+
+typedef Counter Gauge;
+
+// Latency histogram over fixed buckets from 100 us to 10 s
+class Histogram {
+public:
+    static constexpr int kBuckets = 14;
+    static constexpr int64_t kBoundsNs[kBuckets] = {
+        100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000, 25000000,
+        50000000, 100000000, 250000000, 1000000000, 2500000000, 10000000000
+    };
+
+    void observe(int64_t duration_ns) {
+        Shard& shard = shards[shardIndex()];
+        int bucket = 0;
+        while (bucket < kBuckets && duration_ns > kBoundsNs[bucket]) bucket++;
+        shard.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+        shard.sum_ns.fetch_add(duration_ns, std::memory_order_relaxed);
+    }
+
+    struct Snapshot {
+        uint64_t counts[kBuckets + 1] = {};   // last one is +Inf
+        int64_t sum_ns = 0;
+    };
+
+    Snapshot snapshot() const {
+        Snapshot total;
+        for (const Shard& shard : shards) {
+            for (int b = 0; b <= kBuckets; b++) total.counts[b] += shard.counts[b].load(std::memory_order_relaxed);
+            total.sum_ns += shard.sum_ns.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> counts[kBuckets + 1] = {};
+        std::atomic<int64_t> sum_ns{0};
+    };
+    Shard shards[kShards];
+};
+
+// Histograms keyed by one label value, created on first use and never freed.
+// Each thread remembers the ones it has looked up, so the lock is only taken
+// the first time a thread sees a label. Past max_labels values, new ones
+// share the overflow histogram.
+class HistogramFamily {
+public:
+    explicit HistogramFamily(size_t max_labels_ = 256) : max_labels(max_labels_) {}
+
+    Histogram& get(std::string_view label) {
+        thread_local std::unordered_map<std::string, Histogram*> seen;
+        // Keyed on this family's address, then the label
+        const HistogramFamily* self = this;
+        std::string key(reinterpret_cast<const char*>(&self), sizeof(self));
+        key.append(label);
+        auto it = seen.find(key);
+        if (it != seen.end()) return *it->second;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = histograms.find(std::string(label));
+        if (found == histograms.end()) {
+            std::string name(histograms.size() < max_labels ? label : std::string_view(kOverflow));
+            found = histograms.find(name);
+            if (found == histograms.end()) {
+                found = histograms.emplace(name, std::unique_ptr<Histogram>(new Histogram())).first;
+            }
+        }
+        seen.emplace(std::move(key), found->second.get());
+        return *found->second;
+    }
+
+    template <typename Visit>
+    void forEach(Visit visit) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& entry : histograms) visit(entry.first, *entry.second);
+    }
+
+    static constexpr const char* kOverflow = "other";
+
+private:
+    size_t max_labels;
+    std::mutex mutex;
+    std::unordered_map<std::string, std::unique_ptr<Histogram>> histograms;
+};
+
+// Prometheus text exposition format (version 0.0.4)
+class PrometheusText {
+public:
+    static constexpr const char* kContentType = "text/plain; version=0.0.4; charset=utf-8";
+
+    PrometheusText& family(const char* name, const char* type, const char* help) {
+        text += "# HELP ";
+        text += name;
+        text += ' ';
+        text += help;
+        text += "\n# TYPE ";
+        text += name;
+        text += ' ';
+        text += type;
+        text += '\n';
+        return *this;
+    }
+
+    // labels is either empty or already formatted by label()
+    PrometheusText& sample(const char* name, const std::string& labels, double value) {
+        char number[32];
+        std::snprintf(number, sizeof(number), "%.15g", value);
+        text += name;
+        if (!labels.empty()) text += '{' + labels + '}';
+        text += ' ';
+        text += number;
+        text += '\n';
+        return *this;
+    }
+
+    PrometheusText& histogram(const char* name, const std::string& labels, const Histogram& histogram) {
+        Histogram::Snapshot snapshot = histogram.snapshot();
+        std::string bucket_name = std::string(name) + "_bucket";
+        std::string separator = labels.empty() ? "" : ",";
+        uint64_t cumulative = 0;
+        for (int b = 0; b <= Histogram::kBuckets; b++) {
+            cumulative += snapshot.counts[b];
+            char bound[32];
+            if (b < Histogram::kBuckets) {
+                std::snprintf(bound, sizeof(bound), "%g", Histogram::kBoundsNs[b] * 1e-9);
+            } else {
+                std::snprintf(bound, sizeof(bound), "+Inf");
+            }
+            sample(bucket_name.c_str(), labels + separator + "le=\"" + bound + "\"", double(cumulative));
+        }
+        sample((std::string(name) + "_sum").c_str(), labels, snapshot.sum_ns * 1e-9);
+        sample((std::string(name) + "_count").c_str(), labels, double(cumulative));
+        return *this;
+    }
+
+    static std::string label(const char* key, std::string_view value) {
+        std::string formatted = std::string(key) + "=\"";
+        for (char c : value) {
+            if (c == '\\' || c == '"') formatted += '\\';
+            if (c == '\n') {
+                formatted += "\\n";
+                continue;
+            }
+            formatted += c;
+        }
+        return formatted + '"';
+    }
+
+    const std::string& str() const { return text; }
+
+private:
+    std::string text;
+};
+
+} // namespace metrics
@@ -0,0 +1,58 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Minimal fork-join helper for the native engine. Tasks are claimed from a
+// shared counter, so the assignment of tasks to threads varies between runs;
+// callers keep results reproducible by deriving all randomness from the task
+// index rather than the worker.
+//
+// WebAssembly builds without pthreads (-pthread / USE_PTHREADS) run serially.
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    #define SEROJUMP_NO_THREADS 1
+#endif
+
+// Number of workers to use when the caller asks for "all of them" (n <= 0)
+inline int resolveThreadCount(int n_threads) {
+#if defined(SEROJUMP_NO_THREADS)
+    (void)n_threads;
+    return 1;
+#else
+    if (n_threads > 0) return n_threads;
+    unsigned hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? int(hardware) : 1;
+#endif
+}
+
+// Run task(i) for i in [0, n_tasks) on up to n_threads threads (the calling
+// thread included) and wait for all of them to finish.
+template <typename Task>
+void parallelFor(int n_tasks, int n_threads, Task&& task) {
+    int n_workers = std::min(resolveThreadCount(n_threads), n_tasks);
+    if (n_workers <= 1) {
+        for (int i = 0; i < n_tasks; i++) task(i);
+        return;
+    }
+
+#if !defined(SEROJUMP_NO_THREADS)
+    std::atomic<int> next{0};
+    auto worker = [&]() {
+        for (int i = next.fetch_add(1); i < n_tasks; i = next.fetch_add(1)) {
+            task(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(n_workers - 1);
+    for (int w = 1; w < n_workers; w++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+#endif
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Online posterior accumulators. A streaming MCMC run folds every kept draw
+// into these instead of storing the chain, so memory grows with the cohort
+// size and not with the number of steps.
+
+// Welford running mean / variance
+struct RunningMoments {
+    int64_t count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+
+    void add(double x) {
+        count++;
+        double delta = x - mean;
+        mean += delta / count;
+        m2 += delta * (x - mean);
+    }
+
+    // Chan et al. parallel combination, used to merge chains
+    void merge(const RunningMoments& other) {
+        if (other.count == 0) return;
+        if (count == 0) {
+            *this = other;
+            return;
+        }
+        int64_t total = count + other.count;
+        double delta = other.mean - mean;
+        mean += delta * other.count / total;
+        m2 += other.m2 + delta * delta * (double(count) * other.count / total);
+        count = total;
+    }
+
+    double variance() const { return count > 1 ? m2 / (count - 1) : 0.0; }
+    double sd() const { return std::sqrt(variance()); }
+};
+
+// Per-individual summary of the kept draws
+struct IndividualSummary {
+    int64_t n_draws = 0;              // kept (post burn-in, thinned) draws
+    int64_t n_infected = 0;           // of which infected
+    RunningMoments baseline;
+    RunningMoments boost;             // infected draws only
+    RunningMoments infection_time;    // earliest infection, infected draws only
+    RunningMoments infection_count;   // number of infections, all draws
+    RunningMoments log_likelihood;
+
+    double infectionProbability() const {
+        return n_draws > 0 ? double(n_infected) / n_draws : 0.0;
+    }
+
+    void merge(const IndividualSummary& other) {
+        n_draws += other.n_draws;
+        n_infected += other.n_infected;
+        baseline.merge(other.baseline);
+        boost.merge(other.boost);
+        infection_time.merge(other.infection_time);
+        infection_count.merge(other.infection_count);
+        log_likelihood.merge(other.log_likelihood);
+    }
+};
+
+// Summaries for a whole cohort, plus a fixed-bin histogram of all infection
+// times per individual over [hist_start, hist_end) that doubles as a quantile
+// sketch. Histograms are stored flat as [individual][bin].
+struct PosteriorSummary {
+    int n_individuals = 0;
+    int n_bins = 0;
+    double hist_start = 0.0;
+    double hist_end = 1.0;
+    std::vector<IndividualSummary> individuals;
+    std::vector<uint32_t> infection_time_histograms;
+    std::vector<double> acceptance_rates;
+    // Proposal steps adapted during burn-in, averaged over chains
+    std::vector<double> baseline_steps;
+    std::vector<double> boost_steps;
+    std::vector<double> time_steps;
+
+    PosteriorSummary() = default;
+    PosteriorSummary(int n_individuals_, int n_bins_, double hist_start_, double hist_end_)
+        : n_individuals(n_individuals_), n_bins(n_bins_),
+          hist_start(hist_start_), hist_end(hist_end_),
+          individuals(n_individuals_),
+          infection_time_histograms(size_t(n_individuals_) * n_bins_, 0),
+          acceptance_rates(n_individuals_, 0.0),
+          baseline_steps(n_individuals_, 0.0),
+          boost_steps(n_individuals_, 0.0),
+          time_steps(n_individuals_, 0.0) {}
+
+    uint32_t* histogram(int i) { return infection_time_histograms.data() + size_t(i) * n_bins; }
+    const uint32_t* histogram(int i) const { return infection_time_histograms.data() + size_t(i) * n_bins; }
+
+    void addInfectionTime(int i, double t) {
+        if (n_bins <= 0) return;
+        int bin = int((t - hist_start) / (hist_end - hist_start) * n_bins);
+        bin = bin < 0 ? 0 : (bin >= n_bins ? n_bins - 1 : bin);
+        histogram(i)[bin]++;
+    }
+
+    // Quantile q of individual i's infection times (all infections pooled),
+    // linearly interpolated within the histogram bin. NaN when never infected.
+    double infectionTimeQuantile(int i, double q) const {
+        if (n_bins <= 0) return std::nan("");
+        const uint32_t* counts = histogram(i);
+        double total = 0.0;
+        for (int bin = 0; bin < n_bins; bin++) total += counts[bin];
+        if (total == 0.0) return std::nan("");
+        double target = q * total;
+        double bin_width = (hist_end - hist_start) / n_bins;
+        double cumulative = 0.0;
+        for (int bin = 0; bin < n_bins; bin++) {
+            if (counts[bin] > 0 && cumulative + counts[bin] >= target) {
+                double fraction = (target - cumulative) / counts[bin];
+                return hist_start + (bin + fraction) * bin_width;
+            }
+            cumulative += counts[bin];
+        }
+        return hist_end;
+    }
+
+    void merge(const PosteriorSummary& other) {
+        for (int i = 0; i < n_individuals; i++) {
+            individuals[i].merge(other.individuals[i]);
+        }
+        for (size_t k = 0; k < infection_time_histograms.size(); k++) {
+            infection_time_histograms[k] += other.infection_time_histograms[k];
+        }
+    }
+};
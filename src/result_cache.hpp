@@ -0,0 +1,229 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 64-bit FNV-1a, for content-addressing results
+inline uint64_t fnv1a64(const void* data, size_t size, uint64_t hash = 1469598103934665603ULL) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Content-addressed LRU cache of compute results. Entries are charged
+// key + value bytes against a memory budget; the least recently used ones are
+// evicted past it and, with a spill directory, written to disk (which has its
+// own budget, again evicting the oldest files). Files in the directory are
+// re-indexed at startup and memory is spilled on destruction, so results
+// survive a restart. Thread-safe.
+//
+// get() only consults memory and is cheap enough for an event loop;
+// getSpilled() reads the disk and belongs on a compute thread.
+class ResultCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;           // served from memory
+        uint64_t disk_hits = 0;      // served from the spill directory
+        uint64_t misses = 0;         // had to be computed
+        uint64_t evictions = 0;      // dropped from memory
+        uint64_t spills = 0;         // of which written to disk
+        size_t entries = 0;
+        size_t bytes = 0;
+        size_t disk_entries = 0;
+        size_t disk_bytes = 0;
+    };
+
+    ResultCache(size_t memory_budget_, std::string spill_dir_ = "", size_t disk_budget_ = 0)
+        : memory_budget(memory_budget_), spill_dir(std::move(spill_dir_)), disk_budget(disk_budget_) {
+        if (!spill_dir.empty()) indexSpillDirectory();
+    }
+
+    // Whatever is still in memory is spilled too, for the next run
+    ~ResultCache() {
+        if (spill_dir.empty()) return;
+        for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+            writeSpillFile(it->first, it->second);
+        }
+    }
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    bool enabled() const { return memory_budget > 0 || !spill_dir.empty(); }
+
+    bool get(const std::string& key, std::string& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it == index.end()) return false;
+        entries.splice(entries.begin(), entries, it->second);
+        value = it->second->second;
+        counters.hits++;
+        return true;
+    }
+
+    // Look in the spill directory (promoting a hit back into memory); a miss
+    // here is counted as a cache miss
+    bool getSpilled(const std::string& key, std::string& value) {
+        if (!spill_dir.empty() && readSpillFile(key, value)) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                counters.disk_hits++;
+            }
+            put(key, value);
+            return true;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        counters.misses++;
+        return false;
+    }
+
+    void put(const std::string& key, std::string value) {
+        std::vector<std::pair<std::string, std::string>> evicted;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = index.find(key);
+            if (it != index.end()) {
+                bytes -= charge(*it->second);
+                entries.erase(it->second);
+                index.erase(it);
+            }
+            entries.emplace_front(key, std::move(value));
+            index[key] = entries.begin();
+            bytes += charge(entries.front());
+            while (bytes > memory_budget && !entries.empty()) {
+                bytes -= charge(entries.back());
+                index.erase(entries.back().first);
+                counters.evictions++;
+                evicted.push_back(std::move(entries.back()));
+                entries.pop_back();
+            }
+        }
+        // Disk writes happen outside the lock
+        if (spill_dir.empty()) return;
+        for (const auto& entry : evicted) {
+            writeSpillFile(entry.first, entry.second);
+        }
+    }
+
+    Stats stats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats snapshot = counters;
+        snapshot.entries = entries.size();
+        snapshot.bytes = bytes;
+        snapshot.disk_entries = disk_files.size();
+        snapshot.disk_bytes = disk_bytes;
+        return snapshot;
+    }
+
+private:
+    typedef std::pair<std::string, std::string> Entry;
+
+    static size_t charge(const Entry& entry) { return entry.first.size() + entry.second.size(); }
+
+    // Files are named by the key's hash and begin with the key itself, so a
+    // hash collision reads as a miss rather than a wrong result
+    std::string spillPath(const std::string& key) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.result",
+                      (unsigned long long)fnv1a64(key.data(), key.size()));
+        return spill_dir + "/" + name;
+    }
+
+    bool readSpillFile(const std::string& key, std::string& value) {
+        std::string path = spillPath(key);
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) return false;
+        std::string stored_key;
+        if (!std::getline(file, stored_key) || stored_key != key) return false;
+        value.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        std::lock_guard<std::mutex> lock(mutex);
+        touchDiskEntry(path, key.size() + 1 + value.size());
+        return true;
+    }
+
+    void writeSpillFile(const std::string& key, const std::string& value) {
+        if (key.size() + value.size() > disk_budget) return;
+        std::string path = spillPath(key);
+        // Write then rename, so a reader never sees a partial file
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) return;
+            file << key << '\n' << value;
+            if (!file) return;
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, path, error);
+        if (error) return;
+
+        std::vector<std::string> removed;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            counters.spills++;
+            touchDiskEntry(path, key.size() + 1 + value.size());
+            while (disk_bytes > disk_budget && !disk_files.empty()) {
+                disk_bytes -= disk_files.back().second;
+                disk_index.erase(disk_files.back().first);
+                removed.push_back(disk_files.back().first);
+                disk_files.pop_back();
+            }
+        }
+        for (const std::string& old : removed) {
+            std::filesystem::remove(old, error);
+        }
+    }
+
+    // Most recently used first; caller holds the mutex
+    void touchDiskEntry(const std::string& path, size_t size) {
+        auto it = disk_index.find(path);
+        if (it != disk_index.end()) {
+            disk_bytes -= it->second->second;
+            disk_files.erase(it->second);
+        }
+        disk_files.emplace_front(path, size);
+        disk_index[path] = disk_files.begin();
+        disk_bytes += size;
+    }
+
+    // Pick up results spilled by an earlier run, oldest last
+    void indexSpillDirectory() {
+        std::error_code error;
+        std::filesystem::create_directories(spill_dir, error);
+        std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> files;
+        for (std::filesystem::directory_iterator it(spill_dir, error), end; !error && it != end;
+             it.increment(error)) {
+            if (it->is_regular_file(error) && it->path().extension() == ".result") {
+                files.emplace_back(it->last_write_time(error), it->path());
+            }
+        }
+        std::sort(files.begin(), files.end());
+        for (const auto& file : files) {
+            touchDiskEntry(file.second.string(), size_t(std::filesystem::file_size(file.second, error)));
+        }
+    }
+
+    std::mutex mutex;
+    size_t memory_budget;
+    size_t bytes = 0;
+    std::list<Entry> entries;        // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+
+    std::string spill_dir;
+    size_t disk_budget;
+    size_t disk_bytes = 0;
+    std::list<std::pair<std::string, size_t>> disk_files;   // path, size; most recent first
+    std::unordered_map<std::string, std::list<std::pair<std::string, size_t>>::iterator> disk_index;
+
+    Stats counters;
+};
@@ -1,10 +1,26 @@
 #include "serojump.hpp"
+#include "titre_kernel.hpp"
 #include <algorithm>
 #include <cstring>
 #include <limits>
 
+MCMCCounters& mcmcCounters() {
+    static MCMCCounters counters;
+    return counters;
+}
+
+const char* moveTypeName(MoveType move) {
+    switch (move) {
+        case MoveType::Parameters: return "parameters";
+        case MoveType::InfectionTime: return "infection_time";
+        case MoveType::Birth: return "birth";
+        case MoveType::Death: return "death";
+        default: return "gibbs";
+    }
+}
+
 SeroJumpSimulator::SeroJumpSimulator(unsigned seed) 
-    : rng(seed), normal_dist(0.0, 1.0), uniform_dist(0.0, 1.0) {}
+    : seed(seed), rng(seed) {}
 
 double SeroJumpSimulator::computeTitre(double baseline, double boost, double decay_rate,
                                      double infection_time, double sample_time) {
@@ -16,81 +32,124 @@ double SeroJumpSimulator::computeTitre(double baseline, double boost, double dec
     }
 }
 
-Individual SeroJumpSimulator::simulateIndividual(int id, const StudyParams& study_params,
-                                                 const AntibodyParams& ab_params, 
-                                                 int n_samples) {
-    Individual individual;
-    individual.id = id;
-    individual.is_infected = (uniform_dist(rng) < study_params.infection_rate);
+void SeroJumpSimulator::drawIndividual(RngStream& stream, const StudyParams& study_params,
+                                       const AntibodyParams& ab_params, int n_samples,
+                                       unsigned char& is_infected, double& infection_time,
+                                       double& baseline_titre,
+                                       double* sample_times, double* titre_values) {
+    bool infected = (stream.uniform() < study_params.infection_rate);
     
     // Generate baseline titre for this individual
-    individual.baseline_titre = normal_dist(rng) * ab_params.baseline_sd + ab_params.baseline_mean;
+    baseline_titre = stream.normal() * ab_params.baseline_sd + ab_params.baseline_mean;
     
-    // Generate infection time if infected
-    double infection_time = 0.0;
-    if (individual.is_infected) {
-        infection_time = uniform_dist(rng) * (study_params.study_end - study_params.study_start) + study_params.study_start;
-        individual.true_infection_times.push_back(infection_time);
+    // Generate infection time and the boost it caused if infected; the boost is
+    // a property of the infection, shared by every later sample
+    infection_time = -1.0;
+    double boost = 0.0;
+    if (infected) {
+        infection_time = study_params.infection_hazard.sample(stream.uniform(), study_params.study_start,
+                                                              study_params.study_end);
+        boost = stream.normal() * ab_params.boost_sd + ab_params.boost_mean;
     }
+    is_infected = infected ? 1 : 0;
     
-    // Generate sample times uniformly across study period
-    individual.sample_times.resize(n_samples);
-    individual.titre_values.resize(n_samples);
+    // Observation noise for every sample in one batch, added to the true titres below
+    stream.normals(titre_values, n_samples);
     
     for (int i = 0; i < n_samples; i++) {
-        double sample_time = (double(i) / (n_samples - 1)) * (study_params.study_end - study_params.study_start) + study_params.study_start;
-        individual.sample_times[i] = sample_time;
+        // Sample times spread uniformly across the study period (a single sample at its start)
+        double fraction = (n_samples > 1) ? double(i) / (n_samples - 1) : 0.0;
+        double sample_time = fraction * (study_params.study_end - study_params.study_start) + study_params.study_start;
+        sample_times[i] = sample_time;
         
         // Compute true titre based on infection status
-        double true_titre;
-        if (individual.is_infected) {
-            double boost = normal_dist(rng) * ab_params.boost_sd + ab_params.boost_mean;
-            true_titre = computeTitre(individual.baseline_titre, boost, ab_params.decay_rate, 
+        double true_titre = baseline_titre;
+        if (infected) {
+            true_titre = computeTitre(baseline_titre, boost, ab_params.decay_rate, 
                                     infection_time, sample_time);
-        } else {
-            true_titre = individual.baseline_titre;
         }
         
-        // Add observation noise
-        individual.titre_values[i] = true_titre + normal_dist(rng) * ab_params.observation_sd;
+        titre_values[i] = true_titre + titre_values[i] * ab_params.observation_sd;
     }
-    
-    return individual;
 }
 
-std::vector<Individual> SeroJumpSimulator::simulateStudy(const StudyParams& study_params,
-                                                       const AntibodyParams& ab_params,
-                                                       int n_samples_per_individual) {
-    std::vector<Individual> individuals;
-    individuals.reserve(study_params.n_individuals);
+void SeroJumpSimulator::simulateIndividual(Cohort& cohort, int id, const StudyParams& study_params,
+                                           const AntibodyParams& ab_params, 
+                                           int n_samples) {
+    RngStream stream(seed, RngStream::Simulation, unsigned(id));
     
-    for (int i = 0; i < study_params.n_individuals; i++) {
-        individuals.push_back(simulateIndividual(i + 1, study_params, ab_params, n_samples_per_individual));
-    }
+    // Append to the flat arrays, then draw into the new slots
+    size_t offset = cohort.sample_times.size();
+    cohort.sample_times.resize(offset + n_samples);
+    cohort.titre_values.resize(offset + n_samples);
+    unsigned char is_infected;
+    double infection_time, baseline_titre;
+    drawIndividual(stream, study_params, ab_params, n_samples, is_infected, infection_time,
+                   baseline_titre, cohort.sample_times.data() + offset,
+                   cohort.titre_values.data() + offset);
     
-    return individuals;
+    cohort.ids.push_back(id);
+    cohort.is_infected.push_back(is_infected);
+    cohort.baseline_titres.push_back(baseline_titre);
+    cohort.true_infection_times.push_back(infection_time);
+    cohort.offsets.push_back(int(offset) + n_samples);
 }
 
-double SeroJumpSimulator::logLikelihood(const Individual& individual, const IndividualMCMC& params,
-                                       const AntibodyParams& study_params) {
-    double log_lik = 0.0;
+Cohort SeroJumpSimulator::simulateStudy(const StudyParams& study_params,
+                                      const AntibodyParams& ab_params,
+                                      int n_samples_per_individual, int n_threads) {
+    Cohort cohort;
+    simulateChunk(study_params, ab_params, n_samples_per_individual,
+                  0, std::max(0, study_params.n_individuals), cohort, n_threads);
+    return cohort;
+}
+
+void SeroJumpSimulator::simulateChunk(const StudyParams& study_params, const AntibodyParams& ab_params,
+                                      int n_samples_per_individual, int first, int count,
+                                      Cohort& chunk, int n_threads) {
+    int n_samples = n_samples_per_individual;
     
-    for (size_t i = 0; i < individual.sample_times.size(); i++) {
-        double predicted_titre;
-        
-        if (params.infected_state) {
-            predicted_titre = computeTitre(params.baseline, params.boost, study_params.decay_rate,
-                                         params.infection_time, individual.sample_times[i]);
-        } else {
-            predicted_titre = params.baseline;
-        }
-        
-        double residual = individual.titre_values[i] - predicted_titre;
-        log_lik += -0.5 * std::log(2.0 * M_PI * study_params.observation_sd * study_params.observation_sd) 
-                   - 0.5 * (residual * residual) / (study_params.observation_sd * study_params.observation_sd);
+    // Every individual has the same number of samples, so all slots are known
+    // up front and blocks of individuals fill them independently
+    chunk.ids.resize(count);
+    chunk.offsets.resize(count + 1);
+    chunk.is_infected.resize(count);
+    chunk.true_infection_times.resize(count);
+    chunk.baseline_titres.resize(count);
+    chunk.sample_times.resize(size_t(count) * n_samples);
+    chunk.titre_values.resize(size_t(count) * n_samples);
+    for (int i = 0; i <= count; i++) {
+        chunk.offsets[i] = i * n_samples;
     }
     
-    return log_lik;
+    int n_blocks = (count + kParallelBlockSize - 1) / kParallelBlockSize;
+    parallelFor(n_blocks, n_threads, [&](int block) {
+        int end = std::min(count, (block + 1) * kParallelBlockSize);
+        for (int i = block * kParallelBlockSize; i < end; i++) {
+            int id = first + i + 1;
+            RngStream stream(seed, RngStream::Simulation, unsigned(id));
+            size_t offset = size_t(i) * n_samples;
+            chunk.ids[i] = id;
+            drawIndividual(stream, study_params, ab_params, n_samples, chunk.is_infected[i],
+                           chunk.true_infection_times[i], chunk.baseline_titres[i],
+                           chunk.sample_times.data() + offset, chunk.titre_values.data() + offset);
+        }
+    });
+}
+
+double SeroJumpSimulator::logLikelihood(const IndividualView& individual, const IndividualMCMC& params,
+                                       const AntibodyParams& study_params) {
+    return logLikelihoodFrom(individual, params, study_params, 0);
+}
+
+double SeroJumpSimulator::logLikelihoodFrom(const IndividualView& individual, const IndividualMCMC& params,
+                                           const AntibodyParams& study_params, int first_sample) {
+    titre_kernel::LikelihoodConstants constants(study_params.observation_sd);
+    double ssr = titre_kernel::sumSquaredResiduals(
+        individual.sample_times, individual.titre_values, first_sample, individual.n_samples,
+        params.baseline, params.boost, study_params.decay_rate,
+        params.infection_times.data(), params.numInfections());
+    return constants.logLikelihood(ssr, individual.n_samples - first_sample);
 }
 
 double SeroJumpSimulator::logPriorBaseline(double baseline, const AntibodyParams& params) {
@@ -106,130 +165,1139 @@ double SeroJumpSimulator::logPriorBoost(double boost, const AntibodyParams& para
            - 0.5 * (residual * residual) / (params.boost_sd * params.boost_sd);
 }
 
-double SeroJumpSimulator::logPriorInfection(bool infected, double infection_time, 
-                                          const StudyParams& study_params) {
-    if (infected) {
-        // Prior on infection probability + uniform prior on infection time
-        return std::log(study_params.infection_rate) + 
-               std::log(1.0 / (study_params.study_end - study_params.study_start));
-    } else {
-        return std::log(1.0 - study_params.infection_rate);
+double SeroJumpSimulator::logPriorInfections(const InfectionTimes& infection_times,
+                                           const StudyParams& study_params) {
+    int k = infection_times.size();
+    double rate = study_params.infection_rate;
+    if (k == 0) {
+        return std::log(1.0 - rate);
     }
+    if (k > study_params.max_infections) {
+        return -std::numeric_limits<double>::infinity();
+    }
+    
+    // P(k) = rate * rate^(k-1) / sum_{j < max_infections} rate^j, which reduces
+    // to the infected/uninfected prior when max_infections is 1
+    double normaliser = 0.0;
+    double power = 1.0;
+    for (int j = 0; j < study_params.max_infections; j++) {
+        normaliser += power;
+        power *= rate;
+    }
+    double log_count = k * std::log(rate) - std::log(normaliser);
+    
+    // k ordered times drawn from the hazard: density k! prod f(t_i), k! / T^k when uniform
+    const InfectionHazard& hazard = study_params.infection_hazard;
+    if (hazard.empty()) {
+        double duration = study_params.study_end - study_params.study_start;
+        return log_count + std::lgamma(k + 1.0) - k * std::log(duration);
+    }
+    double log_times = std::lgamma(k + 1.0);
+    for (int i = 0; i < k; i++) {
+        log_times += hazard.logDensity(infection_times[i], study_params.study_start, study_params.study_end);
+    }
+    return log_count + log_times;
 }
 
-IndividualMCMC SeroJumpSimulator::proposeParameters(const IndividualMCMC& current,
-                                                   double baseline_step, double boost_step) {
-    IndividualMCMC proposed = current;
-    
-    proposed.baseline = current.baseline + normal_dist(rng) * baseline_step;
+double SeroJumpSimulator::logPrior(const IndividualMCMC& params, const AntibodyParams& ab_params,
+                                  const StudyParams& study_params) {
+    // The boost is part of every state (drawn from its prior while uninfected),
+    // so birth and death moves only change the number of infection times
+    return logPriorBaseline(params.baseline, ab_params) +
+           logPriorBoost(params.boost, ab_params) +
+           logPriorInfections(params.infection_times, study_params);
+}
+
+namespace {
+
+// Posterior of (baseline, boost) given the infection times: the titre model is
+// linear in them, so with their normal priors it is bivariate normal, cut to
+// boost > 0 by the boost prior. log_marginal integrates both out of the
+// likelihood times prior (logPriorBoost is not renormalised for the cut).
+struct ParameterPosterior {
+    double mean_baseline, mean_boost;
+    double var_baseline, var_boost, covariance;
+    double log_marginal;
     
-    if (current.infected_state) {
-        proposed.boost = current.boost + normal_dist(rng) * boost_step;
-        // Ensure boost stays positive
-        proposed.boost = std::max(0.001, proposed.boost);
+    ParameterPosterior(const titre_kernel::LinearStats& stats, const AntibodyParams& ab_params) {
+        double noise_precision = 1.0 / (ab_params.observation_sd * ab_params.observation_sd);
+        double baseline_prior_var = ab_params.baseline_sd * ab_params.baseline_sd;
+        double boost_prior_var = ab_params.boost_sd * ab_params.boost_sd;
+        
+        // Precision matrix and precision-weighted mean
+        double p_aa = stats.n * noise_precision + 1.0 / baseline_prior_var;
+        double p_ab = stats.sum_w * noise_precision;
+        double p_bb = stats.sum_ww * noise_precision + 1.0 / boost_prior_var;
+        double h_a = stats.sum_y * noise_precision + ab_params.baseline_mean / baseline_prior_var;
+        double h_b = stats.sum_wy * noise_precision + ab_params.boost_mean / boost_prior_var;
+        double det = p_aa * p_bb - p_ab * p_ab;
+        
+        var_baseline = p_bb / det;
+        var_boost = p_aa / det;
+        covariance = -p_ab / det;
+        mean_baseline = var_baseline * h_a + covariance * h_b;
+        mean_boost = covariance * h_a + var_boost * h_b;
+        
+        double quadratic = stats.sum_yy * noise_precision
+                         + ab_params.baseline_mean * ab_params.baseline_mean / baseline_prior_var
+                         + ab_params.boost_mean * ab_params.boost_mean / boost_prior_var
+                         - (mean_baseline * h_a + mean_boost * h_b);
+        double positive_boost = 0.5 * std::erfc(-mean_boost / std::sqrt(2.0 * var_boost));
+        log_marginal = -0.5 * stats.n * std::log(2.0 * M_PI / noise_precision)
+                     - 0.5 * std::log(baseline_prior_var * boost_prior_var * det)
+                     - 0.5 * quadratic + std::log(positive_boost);
+    }
+};
+
+// Draw from N(mean, sd^2) truncated to (0, inf): plain rejection while that
+// accepts often, else Robert's (1995) exponential proposal on the tail
+double positiveNormal(RngStream& stream, double mean, double sd) {
+    double alpha = -mean / sd;
+    if (alpha < 0.5) {
+        while (true) {
+            double x = mean + sd * stream.normal();
+            if (x > 0.0) return x;
+        }
+    }
+    double lambda = 0.5 * (alpha + std::sqrt(alpha * alpha + 4.0));
+    while (true) {
+        double z = alpha - std::log(1.0 - stream.uniform()) / lambda;
+        double gap = z - lambda;
+        if (stream.uniform() <= std::exp(-0.5 * gap * gap)) return mean + sd * z;
+    }
+}
+
+// Gamma(shape, 1) draw (Marsaglia and Tsang 2000); shapes below 1 are boosted
+// by one and scaled back by U^(1 / shape)
+double gammaDraw(RngStream& stream, double shape) {
+    if (shape < 1.0) {
+        return gammaDraw(stream, shape + 1.0) * std::pow(1.0 - stream.uniform(), 1.0 / shape);
+    }
+    double d = shape - 1.0 / 3.0;
+    double c = 1.0 / std::sqrt(9.0 * d);
+    while (true) {
+        double x = stream.normal();
+        double v = 1.0 + c * x;
+        if (v <= 0.0) continue;
+        v = v * v * v;
+        if (std::log(1.0 - stream.uniform()) < 0.5 * x * x + d - d * v + d * std::log(v)) return d * v;
+    }
+}
+
+// Variance draw from InvGamma(shape, scale)
+double inverseGammaDraw(RngStream& stream, double shape, double scale) {
+    return scale / gammaDraw(stream, shape);
+}
+
+// Mean of n normal values with sum `sum` and known variance, under a
+// N(prior_mean, prior_var) prior
+double normalMeanDraw(RngStream& stream, double prior_mean, double prior_var,
+                      double sum, double n, double variance) {
+    double precision = 1.0 / prior_var + n / variance;
+    double mean = (prior_mean / prior_var + sum / variance) / precision;
+    return mean + stream.normal() / std::sqrt(precision);
+}
+
+// log P(X > 0) for X ~ N(mean, sd^2): the normaliser of the boost prior
+double logPositiveMass(double mean, double sd) {
+    return std::log(0.5 * std::erfc(-mean / (sd * std::sqrt(2.0))));
+}
+
+// Move-type probabilities for a state with k infections: parameters 0.5,
+// shift 0.3 when infected, and the remainder birth/death. Birth and death
+// split evenly except at k = 0 (birth only) and k = max_infections (death only).
+double birthProbability(int k, int max_infections) {
+    if (k >= max_infections) return 0.0;
+    return k == 0 ? 0.5 : 0.2 * 0.5;
+}
+
+double deathProbability(int k, int max_infections) {
+    if (k == 0) return 0.0;
+    return k >= max_infections ? 0.2 : 0.2 * 0.5;
+}
+
+double reflectIntoWindow(double t, double start, double end) {
+    while (t < start || t > end) {
+        if (t < start) t = 2 * start - t;
+        if (t > end) t = 2 * end - t;
     }
+    return t;
+}
+
+} // namespace
+
+SeroJumpSimulator::MCMCStep SeroJumpSimulator::gibbsParameters(
+    RngStream& stream, const IndividualView& individual, const IndividualMCMC& current,
+    const AntibodyParams& ab_params, const StudyParams& study_params) {
+    MCMCStep result;
+    result.move = MoveType::Gibbs;
+    result.accepted = true;
+    result.acceptance_rate = 1.0;
+    result.params = current;
+    drawParameters(stream, individual, result.params, ab_params, study_params);
     
-    return proposed;
+    MCMCCounters& counters = mcmcCounters();
+    counters.proposed[int(MoveType::Gibbs)].add();
+    counters.accepted[int(MoveType::Gibbs)].add();
+    return result;
 }
 
-IndividualMCMC SeroJumpSimulator::proposeInfectionTime(const IndividualMCMC& current,
-                                                     const StudyParams& study_params) {
-    IndividualMCMC proposed = current;
+void SeroJumpSimulator::drawParameters(RngStream& stream, const IndividualView& individual,
+                                       IndividualMCMC& state, const AntibodyParams& ab_params,
+                                       const StudyParams& study_params) {
+    titre_kernel::LinearStats stats = titre_kernel::linearStats(
+        individual.sample_times, individual.titre_values, individual.n_samples, ab_params.decay_rate,
+        state.infection_times.data(), state.numInfections());
+    ParameterPosterior posterior(stats, ab_params);
     
-    if (current.infected_state) {
-        // Random walk on infection time within study bounds
-        double time_step = (study_params.study_end - study_params.study_start) * 0.1;
-        proposed.infection_time = current.infection_time + normal_dist(rng) * time_step;
-        
-        // Reflect at boundaries
-        while (proposed.infection_time < study_params.study_start || 
-               proposed.infection_time > study_params.study_end) {
-            if (proposed.infection_time < study_params.study_start) {
-                proposed.infection_time = 2 * study_params.study_start - proposed.infection_time;
-            }
-            if (proposed.infection_time > study_params.study_end) {
-                proposed.infection_time = 2 * study_params.study_end - proposed.infection_time;
-            }
+    // boost from its truncated marginal, then baseline given boost
+    state.boost = positiveNormal(stream, posterior.mean_boost, std::sqrt(posterior.var_boost));
+    double slope = posterior.covariance / posterior.var_boost;
+    state.baseline = posterior.mean_baseline + slope * (state.boost - posterior.mean_boost)
+                   + stream.normal() * std::sqrt(posterior.var_baseline - slope * posterior.covariance);
+    
+    titre_kernel::LikelihoodConstants constants(ab_params.observation_sd);
+    state.log_likelihood = constants.logLikelihood(stats.sumSquaredResiduals(state.baseline, state.boost),
+                                                   stats.n);
+    state.log_prior = logPrior(state, ab_params, study_params);
+}
+
+double SeroJumpSimulator::logMarginalLikelihood(const IndividualView& individual,
+                                                const InfectionTimes& infection_times,
+                                                const AntibodyParams& ab_params) {
+    titre_kernel::LinearStats stats = titre_kernel::linearStats(
+        individual.sample_times, individual.titre_values, individual.n_samples, ab_params.decay_rate,
+        infection_times.data(), infection_times.size());
+    return ParameterPosterior(stats, ab_params).log_marginal;
+}
+
+void SeroJumpSimulator::samplePopulation(RngStream& stream, const PopulationSums& sums,
+                                         const HyperPriors& priors, AntibodyParams& ab_params,
+                                         StudyParams& study_params) {
+    double n = sums.individuals;
+    double mean_prior_var = priors.mean_sd * priors.mean_sd;
+    
+    // Baselines are normal given their mean and sd
+    double baseline_sd = ab_params.baseline_sd;
+    double baseline_mean = normalMeanDraw(stream, priors.centre.baseline_mean, mean_prior_var,
+                                          sums.sum_baseline, n, baseline_sd * baseline_sd);
+    double deviations = std::max(0.0, sums.sum_baseline_sq - 2.0 * baseline_mean * sums.sum_baseline
+                                    + n * baseline_mean * baseline_mean);
+    double baseline_scale = (priors.variance_shape - 1.0) * priors.centre.baseline_sd * priors.centre.baseline_sd;
+    ab_params.baseline_mean = baseline_mean;
+    ab_params.baseline_sd = std::sqrt(inverseGammaDraw(stream, priors.variance_shape + 0.5 * n,
+                                                       baseline_scale + 0.5 * deviations));
+    
+    // Boosts are normal cut at 0, so their likelihood carries P(boost > 0)^-n,
+    // which is far too sharp for a draw from the uncut conditional to pass as a
+    // proposal once n is large. Random-walk Metropolis on the mean and the log
+    // sd instead, with steps at the uncut conditionals' spread.
+    double boost_scale = (priors.variance_shape - 1.0) * priors.centre.boost_sd * priors.centre.boost_sd;
+    auto logBoostTarget = [&](double mean, double sd) {
+        double variance = sd * sd;
+        double spread = std::max(0.0, sums.sum_boost_sq - 2.0 * mean * sums.sum_boost + n * mean * mean);
+        double prior_offset = mean - priors.centre.boost_mean;
+        // inverse-gamma prior on the variance, with the Jacobian of log sd
+        return -0.5 * prior_offset * prior_offset / mean_prior_var
+             - priors.variance_shape * std::log(variance) - boost_scale / variance
+             - n * std::log(sd) - 0.5 * spread / variance - n * logPositiveMass(mean, sd);
+    };
+    double current = logBoostTarget(ab_params.boost_mean, ab_params.boost_sd);
+    double mean = ab_params.boost_mean + 2.4 * ab_params.boost_sd / std::sqrt(n + 1.0) * stream.normal();
+    double proposed = logBoostTarget(mean, ab_params.boost_sd);
+    if (std::log(stream.uniform()) < proposed - current) {
+        ab_params.boost_mean = mean;
+        current = proposed;
+    }
+    double sd = ab_params.boost_sd * std::exp(2.4 / std::sqrt(2.0 * (n + 1.0)) * stream.normal());
+    if (std::log(stream.uniform()) < logBoostTarget(ab_params.boost_mean, sd) - current) {
+        ab_params.boost_sd = sd;
+    }
+    
+    // Observation noise from the residuals of every sample
+    double noise_scale = (priors.variance_shape - 1.0) * priors.centre.observation_sd * priors.centre.observation_sd;
+    ab_params.observation_sd = std::sqrt(inverseGammaDraw(stream, priors.variance_shape + 0.5 * sums.samples,
+                                                          noise_scale + 0.5 * sums.sum_squared_residuals));
+    
+    // Infection rate: with one infection at most, infected individuals are
+    // Bernoulli(rate) and the beta prior is conjugate. Otherwise P(k) is
+    // rate^k / Z(rate) for k >= 1, Z = sum_{j < max} rate^j, and the rate takes a
+    // random-walk step on the logit scale.
+    double a = priors.rate_alpha + sums.infected + sums.extra_infections;
+    double b = priors.rate_beta + sums.uninfected;
+    if (study_params.max_infections == 1) {
+        double x = gammaDraw(stream, a);
+        double y = gammaDraw(stream, b);
+        study_params.infection_rate = std::min(std::max(x / (x + y), 1e-12), 1.0 - 1e-12);
+        return;
+    }
+    auto logRateTarget = [&](double rate) {
+        double normaliser = 0.0;
+        double power = 1.0;
+        for (int j = 0; j < study_params.max_infections; j++) {
+            normaliser += power;
+            power *= rate;
         }
+        // beta prior and likelihood, with the Jacobian of the logit
+        return a * std::log(rate) + b * std::log(1.0 - rate) - sums.infected * std::log(normaliser);
+    };
+    double rate = study_params.infection_rate;
+    double logit = std::log(rate / (1.0 - rate)) + 2.4 / std::sqrt(a + b) * stream.normal();
+    double proposed_rate = std::min(std::max(1.0 / (1.0 + std::exp(-logit)), 1e-12), 1.0 - 1e-12);
+    if (std::log(stream.uniform()) < logRateTarget(proposed_rate) - logRateTarget(rate)) {
+        study_params.infection_rate = proposed_rate;
     }
+}
+
+SeroJumpSimulator::Proposal SeroJumpSimulator::proposeParameters(
+    RngStream& stream, const IndividualMCMC& current, double baseline_step, double boost_step) {
+    Proposal proposal = { current, -std::numeric_limits<double>::infinity(), 0.0 };
+    
+    // Symmetric random walk; a non-positive boost is rejected by its prior
+    proposal.params.baseline = current.baseline + stream.normal() * baseline_step;
+    proposal.params.boost = current.boost + stream.normal() * boost_step;
     
-    return proposed;
+    return proposal;
 }
 
-IndividualMCMC SeroJumpSimulator::proposeInfectionState(const IndividualMCMC& current) {
-    IndividualMCMC proposed = current;
-    proposed.infected_state = !current.infected_state;
+SeroJumpSimulator::Proposal SeroJumpSimulator::proposeInfectionTime(
+    RngStream& stream, const IndividualMCMC& current, double time_step,
+    const StudyParams& study_params) {
+    Proposal proposal = { current, std::numeric_limits<double>::infinity(), 0.0 };
+    if (!current.infected()) return proposal;
     
-    if (proposed.infected_state && !current.infected_state) {
-        // Moving from uninfected to infected - need to initialize boost and infection time
-        proposed.boost = 1.0; // Default boost
-        proposed.infection_time = 0.5; // Middle of study period (will be properly set by caller)
+    // Random walk on one infection time within study bounds, reflected at the edges
+    int index = std::min(int(stream.uniform() * current.numInfections()), current.numInfections() - 1);
+    double old_time = current.infection_times[index];
+    double new_time = reflectIntoWindow(old_time + stream.normal() * time_step,
+                                        study_params.study_start, study_params.study_end);
+    
+    proposal.params.infection_times.erase(index);
+    proposal.params.infection_times.insertSorted(new_time);
+    proposal.changed_from = std::min(old_time, new_time);
+    return proposal;
+}
+
+SeroJumpSimulator::Proposal SeroJumpSimulator::proposeGridTime(
+    RngStream& stream, const IndividualView& individual, const IndividualMCMC& current,
+    const AntibodyParams& ab_params, const StudyParams& study_params) {
+    Proposal proposal = { current, std::numeric_limits<double>::infinity(), 0.0 };
+    if (!current.infected()) return proposal;
+    
+    int index = std::min(int(stream.uniform() * current.numInfections()), current.numInfections() - 1);
+    double old_time = current.infection_times[index];
+    InfectionTimes others = current.infection_times;
+    others.erase(index);
+    
+    // Squared residuals with the infection at each cell midpoint
+    thread_local std::vector<double> residuals, log_weights, weights;
+    int n_cells = study_params.time_grid;
+    residuals.resize(individual.n_samples);
+    log_weights.resize(n_cells);
+    weights.resize(n_cells);
+    titre_kernel::residuals(individual.sample_times, individual.titre_values, individual.n_samples,
+                            current.baseline, current.boost, ab_params.decay_rate,
+                            others.data(), others.size(), residuals.data());
+    double spacing = (study_params.study_end - study_params.study_start) / n_cells;
+    titre_kernel::gridSquaredResiduals(individual.sample_times, residuals.data(), individual.n_samples,
+                                       current.boost, ab_params.decay_rate,
+                                       study_params.study_start + 0.5 * spacing, spacing, n_cells,
+                                       log_weights.data());
+    
+    // Log-likelihood up to a constant, plus the hazard's log-density at the
+    // midpoint (the other infections' prior terms do not depend on the cell)
+    double inv_two_var = 0.5 / (ab_params.observation_sd * ab_params.observation_sd);
+    const InfectionHazard& hazard = study_params.infection_hazard;
+    double best = -std::numeric_limits<double>::infinity();
+    for (int g = 0; g < n_cells; g++) {
+        log_weights[g] *= -inv_two_var;
+        if (!hazard.empty()) {
+            log_weights[g] += hazard.logDensity(study_params.study_start + (g + 0.5) * spacing,
+                                                study_params.study_start, study_params.study_end);
+        }
+        best = std::max(best, log_weights[g]);
+    }
+    titre_kernel::expShifted(log_weights.data(), best, n_cells, weights.data());
+    double total = 0.0;
+    for (double weight : weights) total += weight;
+    
+    double target = stream.uniform() * total;
+    int cell = 0;
+    while (cell < n_cells - 1 && target >= weights[cell]) {
+        target -= weights[cell];
+        cell++;
     }
+    double new_time = study_params.study_start + (cell + stream.uniform()) * spacing;
+    int old_cell = std::min(std::max(int((old_time - study_params.study_start) / spacing), 0), n_cells - 1);
+    
+    proposal.params.infection_times = others;
+    proposal.params.infection_times.insertSorted(new_time);
+    proposal.changed_from = std::min(old_time, new_time);
+    // q(t) = p(cell of t) / spacing both ways; the normaliser cancels
+    proposal.log_hastings = log_weights[old_cell] - log_weights[cell];
+    return proposal;
+}
+
+SeroJumpSimulator::Proposal SeroJumpSimulator::proposeBirth(
+    RngStream& stream, const IndividualMCMC& current, const StudyParams& study_params) {
+    Proposal proposal = { current, 0.0, 0.0 };
+    int k = current.numInfections();
+    const InfectionHazard& hazard = study_params.infection_hazard;
+    double new_time = hazard.sample(stream.uniform(), study_params.study_start, study_params.study_end);
     
-    return proposed;
+    proposal.params.infection_times.insertSorted(new_time);
+    proposal.changed_from = new_time;
+    // Forward: pick birth, draw the time from the hazard. Reverse: pick death, remove this one of k + 1.
+    proposal.log_hastings = std::log(deathProbability(k + 1, study_params.max_infections) / (k + 1))
+                          - std::log(birthProbability(k, study_params.max_infections))
+                          - hazard.logDensity(new_time, study_params.study_start, study_params.study_end);
+    return proposal;
+}
+
+SeroJumpSimulator::Proposal SeroJumpSimulator::proposeDeath(
+    RngStream& stream, const IndividualMCMC& current, const StudyParams& study_params) {
+    Proposal proposal = { current, 0.0, 0.0 };
+    int k = current.numInfections();
+    int index = std::min(int(stream.uniform() * k), k - 1);
+    double removed = current.infection_times[index];
+    
+    proposal.changed_from = removed;
+    proposal.params.infection_times.erase(index);
+    proposal.log_hastings = std::log(birthProbability(k - 1, study_params.max_infections))
+                          + study_params.infection_hazard.logDensity(removed, study_params.study_start,
+                                                                     study_params.study_end)
+                          - std::log(deathProbability(k, study_params.max_infections) / k);
+    return proposal;
 }
 
 SeroJumpSimulator::MCMCStep SeroJumpSimulator::mcmcStepIndividual(
-    const Individual& individual, const IndividualMCMC& current_params,
+    const IndividualView& individual, const IndividualMCMC& current_params,
     const AntibodyParams& study_params, const StudyParams& study_settings) {
+    return mcmcStepIndividual(rng, individual, current_params, ProposalScales::defaults(study_settings),
+                              study_params, study_settings);
+}
+
+SeroJumpSimulator::MCMCStep SeroJumpSimulator::mcmcStepIndividual(
+    const IndividualView& individual, const IndividualMCMC& current_params,
+    const ProposalScales& scales, const AntibodyParams& study_params,
+    const StudyParams& study_settings) {
+    return mcmcStepIndividual(rng, individual, current_params, scales, study_params, study_settings);
+}
+
+SeroJumpSimulator::MCMCStep SeroJumpSimulator::mcmcStepIndividual(
+    RngStream& stream, const IndividualView& individual, const IndividualMCMC& current_params,
+    const ProposalScales& scales, const AntibodyParams& study_params,
+    const StudyParams& study_settings) {
     
     MCMCStep result;
     result.accepted = false;
     result.acceptance_rate = 0.0;
     
-    // Choose proposal type randomly
-    double proposal_type = uniform_dist(rng);
-    IndividualMCMC proposed;
+    // Choose the move: parameters, shift an infection time, or birth/death
+    int k = current_params.numInfections();
+    double proposal_type = stream.uniform();
+    Proposal proposal;
+    bool collapse = study_settings.gibbs_parameters;
     
-    if (proposal_type < 0.5) {
-        // Parameter update (baseline and boost)
-        proposed = proposeParameters(current_params, 0.1, 0.2);
-    } else if (proposal_type < 0.8 && current_params.infected_state) {
-        // Infection time update (only if currently infected)
-        proposed = proposeInfectionTime(current_params, study_settings);
+    if (proposal_type < 0.5 && study_settings.gibbs_parameters) {
+        return gibbsParameters(stream, individual, current_params, study_params, study_settings);
+    } else if (proposal_type < 0.5) {
+        result.move = MoveType::Parameters;
+        proposal = proposeParameters(stream, current_params, scales.baseline_step, scales.boost_step);
+    } else if (proposal_type < 0.8 && k > 0 && study_settings.time_grid > 0) {
+        // Scored at fixed baseline and boost, also in Gibbs mode: the grid
+        // depends on them, so it cannot be collapsed over them
+        result.move = MoveType::InfectionTime;
+        proposal = proposeGridTime(stream, individual, current_params, study_params, study_settings);
+        collapse = false;
+    } else if (proposal_type < 0.8 && k > 0) {
+        result.move = MoveType::InfectionTime;
+        proposal = proposeInfectionTime(stream, current_params, scales.time_step, study_settings);
     } else {
-        // State change (infected/uninfected)
-        proposed = proposeInfectionState(current_params);
-        if (proposed.infected_state && !current_params.infected_state) {
-            // Initialize infection time uniformly
-            proposed.infection_time = uniform_dist(rng) * (study_settings.study_end - study_settings.study_start) + study_settings.study_start;
+        double birth = birthProbability(k, study_settings.max_infections);
+        double death = deathProbability(k, study_settings.max_infections);
+        if (stream.uniform() * (birth + death) < birth) {
+            result.move = MoveType::Birth;
+            proposal = proposeBirth(stream, current_params, study_settings);
+        } else {
+            result.move = MoveType::Death;
+            proposal = proposeDeath(stream, current_params, study_settings);
         }
     }
+    const IndividualMCMC& proposed = proposal.params;
     
-    // Calculate log-likelihoods and priors
-    double current_log_lik = logLikelihood(individual, current_params, study_params);
-    double proposed_log_lik = logLikelihood(individual, proposed, study_params);
-    
-    double current_log_prior = logPriorBaseline(current_params.baseline, study_params) +
-                              logPriorInfection(current_params.infected_state, current_params.infection_time, study_settings);
-    if (current_params.infected_state) {
-        current_log_prior += logPriorBoost(current_params.boost, study_params);
+    if (collapse) {
+        return collapsedTimeMove(stream, individual, current_params, proposal, result.move,
+                                 study_params, study_settings);
     }
     
-    double proposed_log_prior = logPriorBaseline(proposed.baseline, study_params) +
-                               logPriorInfection(proposed.infected_state, proposed.infection_time, study_settings);
-    if (proposed.infected_state) {
-        proposed_log_prior += logPriorBoost(proposed.boost, study_params);
+    // Score the proposal only; the current state's terms are cached. Samples at or
+    // before changed_from predict the same titre under both states, so when just
+    // the tail of the series is affected, re-score it and apply the difference.
+    double proposed_log_lik;
+    int first_changed = int(std::upper_bound(individual.sample_times,
+                                             individual.sample_times + individual.n_samples,
+                                             proposal.changed_from) - individual.sample_times);
+    if (first_changed == 0) {
+        proposed_log_lik = logLikelihood(individual, proposed, study_params);
+    } else {
+        proposed_log_lik = current_params.log_likelihood
+                         + logLikelihoodFrom(individual, proposed, study_params, first_changed)
+                         - logLikelihoodFrom(individual, current_params, study_params, first_changed);
     }
+    double proposed_log_prior = logPrior(proposed, study_params, study_settings);
     
-    // Metropolis-Hastings acceptance
-    double log_alpha = proposed_log_lik + proposed_log_prior - current_log_lik - current_log_prior;
+    // Metropolis-Hastings-Green acceptance
+    double log_alpha = proposed_log_lik + proposed_log_prior
+                     - current_params.log_likelihood - current_params.log_prior
+                     + proposal.log_hastings;
+    result.acceptance_rate = std::min(1.0, std::exp(log_alpha));
     
-    if (std::log(uniform_dist(rng)) < log_alpha) {
+    MCMCCounters& counters = mcmcCounters();
+    counters.proposed[int(result.move)].add();
+    if (std::log(stream.uniform()) < log_alpha) {
         result.params = proposed;
         result.params.log_likelihood = proposed_log_lik;
+        result.params.log_prior = proposed_log_prior;
         result.accepted = true;
-        result.acceptance_rate = std::min(1.0, std::exp(log_alpha));
+        counters.accepted[int(result.move)].add();
     } else {
         result.params = current_params;
-        result.params.log_likelihood = current_log_lik;
         result.accepted = false;
-        result.acceptance_rate = std::min(1.0, std::exp(log_alpha));
     }
     
     return result;
 }
 
+SeroJumpSimulator::MCMCStep SeroJumpSimulator::collapsedTimeMove(
+    RngStream& stream, const IndividualView& individual, const IndividualMCMC& current_params,
+    const Proposal& proposal, MoveType move, const AntibodyParams& ab_params,
+    const StudyParams& study_params) {
+    MCMCStep result;
+    result.move = move;
+    
+    // Time moves leave baseline and boost alone, so the prior ratio is the
+    // infection-time prior's
+    double log_alpha = logMarginalLikelihood(individual, proposal.params.infection_times, ab_params)
+                     - logMarginalLikelihood(individual, current_params.infection_times, ab_params)
+                     + logPrior(proposal.params, ab_params, study_params) - current_params.log_prior
+                     + proposal.log_hastings;
+    result.acceptance_rate = std::min(1.0, std::exp(log_alpha));
+    
+    MCMCCounters& counters = mcmcCounters();
+    counters.proposed[int(move)].add();
+    if (std::log(stream.uniform()) < log_alpha) {
+        result.params = proposal.params;
+        drawParameters(stream, individual, result.params, ab_params, study_params);
+        result.accepted = true;
+        counters.accepted[int(move)].add();
+    } else {
+        result.params = current_params;
+        result.accepted = false;
+    }
+    return result;
+}
+
+IndividualMCMC SeroJumpSimulator::initialState(const IndividualView& individual,
+                                             const AntibodyParams& ab_params,
+                                             const StudyParams& study_params) {
+    IndividualMCMC state;
+    state.baseline = ab_params.baseline_mean;
+    state.boost = ab_params.boost_mean;
+    state.infection_prob_prior = study_params.infection_rate;
+    state.log_likelihood = logLikelihood(individual, state, ab_params);
+    state.log_prior = logPrior(state, ab_params, study_params);
+    return state;
+}
+
+IndividualMCMC SeroJumpSimulator::dispersedInitialState(RngStream& stream, const IndividualView& individual,
+                                                     const AntibodyParams& ab_params,
+                                                     const StudyParams& study_params) {
+    IndividualMCMC state;
+    state.baseline = ab_params.baseline_mean + stream.normal() * ab_params.baseline_sd;
+    state.boost = std::max(0.001, ab_params.boost_mean + stream.normal() * ab_params.boost_sd);
+    bool infected = stream.uniform() < study_params.infection_rate;
+    double infection_time = study_params.infection_hazard.sample(stream.uniform(), study_params.study_start,
+                                                                 study_params.study_end);
+    if (infected) {
+        state.infection_times.push_back(infection_time);
+    }
+    state.infection_prob_prior = study_params.infection_rate;
+    state.log_likelihood = logLikelihood(individual, state, ab_params);
+    state.log_prior = logPrior(state, ab_params, study_params);
+    return state;
+}
+
+SeroJumpSimulator::MCMCResults SeroJumpSimulator::runMCMCStudy(
+    const Cohort& cohort, const AntibodyParams& ab_params,
+    const StudyParams& study_params, int n_steps, int burnin) {
+    
+    MCMCResults results;
+    results.total_steps = n_steps;
+    results.burnin_steps = burnin;
+    results.chains.resize(cohort.size());
+    results.acceptance_rates.assign(cohort.size(), 0.0);
+    results.proposal_scales.assign(cohort.size(), ProposalScales::defaults(study_params));
+    
+    for (int i = 0; i < cohort.size(); i++) {
+        std::vector<IndividualMCMC>& chain = results.chains[i];
+        chain.reserve(n_steps);
+        results.acceptance_rates[i] = runChainIndividual(
+            cohort.individual(i), ab_params, study_params, n_steps, burnin,
+            results.proposal_scales[i],
+            [&chain](int, const IndividualMCMC& state) { chain.push_back(state); });
+    }
+    
+    return results;
+}
+
+std::vector<SeroJumpSimulator::MCMCResults> SeroJumpSimulator::runMCMCStudyParallel(
+    const Cohort& cohort, const AntibodyParams& ab_params, const StudyParams& study_params,
+    int n_steps, int burnin, int n_chains, int n_threads) {
+    
+    int n_individuals = cohort.size();
+    std::vector<IndividualView> individuals;
+    individuals.reserve(n_individuals);
+    for (int i = 0; i < n_individuals; i++) {
+        individuals.push_back(cohort.individual(i));
+    }
+    
+    std::vector<MCMCResults> results(n_chains);
+    for (auto& chain_results : results) {
+        chain_results.total_steps = n_steps;
+        chain_results.burnin_steps = burnin;
+        chain_results.chains.assign(n_individuals, std::vector<IndividualMCMC>(n_steps));
+        chain_results.acceptance_rates.assign(n_individuals, 0.0);
+    }
+    
+    std::vector<double> acceptance_rates(size_t(n_chains) * n_individuals);
+    std::vector<ProposalScales> proposal_scales(size_t(n_chains) * n_individuals);
+    runChainsParallel(individuals, ab_params, study_params, n_steps, burnin, n_chains, n_threads,
+                      acceptance_rates.data(), proposal_scales.data(),
+                      [&](int chain, int i, int step, const IndividualMCMC& state) {
+                          results[chain].chains[i][step] = state;
+                      });
+    
+    for (int chain = 0; chain < n_chains; chain++) {
+        std::copy(acceptance_rates.begin() + size_t(chain) * n_individuals,
+                  acceptance_rates.begin() + size_t(chain + 1) * n_individuals,
+                  results[chain].acceptance_rates.begin());
+        results[chain].proposal_scales.assign(proposal_scales.begin() + size_t(chain) * n_individuals,
+                                              proposal_scales.begin() + size_t(chain + 1) * n_individuals);
+    }
+    
+    return results;
+}
+
+PosteriorSummary SeroJumpSimulator::runMCMCStudySummary(
+    const Cohort& cohort, const AntibodyParams& ab_params, const StudyParams& study_params,
+    int n_steps, int burnin, int thin, int n_bins, int n_chains, int n_threads) {
+    
+    std::vector<IndividualView> individuals;
+    individuals.reserve(cohort.size());
+    for (int i = 0; i < cohort.size(); i++) {
+        individuals.push_back(cohort.individual(i));
+    }
+    return runMCMCStudySummary(individuals, ab_params, study_params, n_steps, burnin, thin,
+                               n_bins, n_chains, n_threads);
+}
+
+namespace {
+
+// One summary per chain so concurrent chains of the same individual never
+// share an accumulator; they are merged once the run is finished
+std::vector<PosteriorSummary> makeChainSummaries(int n_chains, int n_individuals, int n_bins,
+                                                 const StudyParams& study_params) {
+    std::vector<PosteriorSummary> chain_summaries;
+    chain_summaries.reserve(n_chains);
+    for (int chain = 0; chain < n_chains; chain++) {
+        chain_summaries.emplace_back(n_individuals, n_bins, study_params.study_start, study_params.study_end);
+    }
+    return chain_summaries;
+}
+
+// Fold one kept draw of individual i into its chain's summary
+void addSummaryDraw(PosteriorSummary& summary, int i, const IndividualMCMC& state) {
+    IndividualSummary& individual = summary.individuals[i];
+    individual.n_draws++;
+    individual.baseline.add(state.baseline);
+    individual.log_likelihood.add(state.log_likelihood);
+    individual.infection_count.add(state.numInfections());
+    if (state.infected()) {
+        individual.n_infected++;
+        individual.boost.add(state.boost);
+        individual.infection_time.add(state.firstInfectionTime());
+        for (double infection_time : state.infection_times) {
+            summary.addInfectionTime(i, infection_time);
+        }
+    }
+}
+
+// Merge the per-chain summaries and average acceptance rates and adapted
+// scales (both [chain][individual]) over chains
+PosteriorSummary mergeChainSummaries(std::vector<PosteriorSummary>& chain_summaries,
+                                     const std::vector<double>& acceptance_rates,
+                                     const std::vector<ProposalScales>& proposal_scales) {
+    int n_chains = int(chain_summaries.size());
+    PosteriorSummary summary = std::move(chain_summaries[0]);
+    for (int chain = 1; chain < n_chains; chain++) {
+        summary.merge(chain_summaries[chain]);
+    }
+    int n_individuals = summary.n_individuals;
+    for (int i = 0; i < n_individuals; i++) {
+        double total = 0.0;
+        ProposalScales total_scales = { 0.0, 0.0, 0.0 };
+        for (int chain = 0; chain < n_chains; chain++) {
+            size_t index = size_t(chain) * n_individuals + i;
+            total += acceptance_rates[index];
+            total_scales.baseline_step += proposal_scales[index].baseline_step;
+            total_scales.boost_step += proposal_scales[index].boost_step;
+            total_scales.time_step += proposal_scales[index].time_step;
+        }
+        summary.acceptance_rates[i] = total / n_chains;
+        summary.baseline_steps[i] = total_scales.baseline_step / n_chains;
+        summary.boost_steps[i] = total_scales.boost_step / n_chains;
+        summary.time_steps[i] = total_scales.time_step / n_chains;
+    }
+    return summary;
+}
+
+// Refresh report from the monitor. Targets are laid out as the baseline of
+// every individual, then their infection counts, then the two cohort totals.
+void updateConvergenceReport(const ConvergenceMonitor& monitor, const ConvergenceOptions& options,
+                             int n_individuals, ConvergenceReport& report) {
+    auto meets = [&](double rhat, double ess) {
+        return rhat <= options.max_rhat && ess >= options.min_ess;
+    };
+    
+    report.baseline_rhat.resize(n_individuals);
+    report.baseline_ess.resize(n_individuals);
+    report.infection_rhat.resize(n_individuals);
+    report.infection_ess.resize(n_individuals);
+    report.laggards.clear();
+    for (int i = 0; i < n_individuals; i++) {
+        report.baseline_rhat[i] = monitor.splitRhat(i);
+        report.baseline_ess[i] = monitor.ess(i);
+        report.infection_rhat[i] = monitor.splitRhat(n_individuals + i);
+        report.infection_ess[i] = monitor.ess(n_individuals + i);
+        if (!meets(report.baseline_rhat[i], report.baseline_ess[i]) ||
+            !meets(report.infection_rhat[i], report.infection_ess[i])) {
+            report.laggards.push_back(i);
+        }
+    }
+    
+    report.total_infections_rhat = monitor.splitRhat(2 * n_individuals);
+    report.total_infections_ess = monitor.ess(2 * n_individuals);
+    report.log_likelihood_rhat = monitor.splitRhat(2 * n_individuals + 1);
+    report.log_likelihood_ess = monitor.ess(2 * n_individuals + 1);
+    report.study_laggard = !meets(report.total_infections_rhat, report.total_infections_ess) ||
+                           !meets(report.log_likelihood_rhat, report.log_likelihood_ess);
+    report.converged = report.laggards.empty() && !report.study_laggard;
+}
+
+} // namespace
+
+PosteriorSummary SeroJumpSimulator::runMCMCStudySummary(
+    const std::vector<IndividualView>& individuals, const AntibodyParams& ab_params,
+    const StudyParams& study_params, int n_steps, int burnin, int thin, int n_bins,
+    int n_chains, int n_threads) {
+    
+    int n_individuals = int(individuals.size());
+    thin = std::max(1, thin);
+    
+    std::vector<PosteriorSummary> chain_summaries =
+        makeChainSummaries(n_chains, n_individuals, n_bins, study_params);
+    std::vector<double> acceptance_rates(size_t(n_chains) * n_individuals);
+    std::vector<ProposalScales> proposal_scales(size_t(n_chains) * n_individuals);
+    
+    runChainsParallel(individuals, ab_params, study_params, n_steps, burnin, n_chains, n_threads,
+                      acceptance_rates.data(), proposal_scales.data(),
+                      [&](int chain, int i, int step, const IndividualMCMC& state) {
+                          if (step < burnin || (step - burnin) % thin != 0) return;
+                          addSummaryDraw(chain_summaries[chain], i, state);
+                      });
+    
+    return mergeChainSummaries(chain_summaries, acceptance_rates, proposal_scales);
+}
+
+PosteriorSummary SeroJumpSimulator::runMCMCStudySummary(
+    const std::vector<IndividualView>& individuals, const AntibodyParams& ab_params,
+    const StudyParams& study_params, int max_steps, int burnin, int thin, int n_bins,
+    int n_chains, int n_threads, const ConvergenceOptions& options, ConvergenceReport& report) {
+    
+    int n_individuals = int(individuals.size());
+    int n_blocks = (n_individuals + kParallelBlockSize - 1) / kParallelBlockSize;
+    int n_tasks = n_chains * n_blocks;
+    int interval = std::max(1, options.check_interval);
+    thin = std::max(1, thin);
+    // Acceptance is only counted after burn-in, as in runChainIndividual
+    int counted_from = (burnin < max_steps) ? burnin : 0;
+    
+    std::vector<PosteriorSummary> chain_summaries =
+        makeChainSummaries(n_chains, n_individuals, n_bins, study_params);
+    
+    // Chains pause between segments, so their state lives here: a state, scales
+    // and acceptance count per (chain, individual). Streams are keyed on the
+    // step, so they are rebuilt each segment rather than kept.
+    std::vector<IndividualMCMC> states(size_t(n_chains) * n_individuals);
+    std::vector<ProposalScales> proposal_scales(states.size(), ProposalScales::defaults(study_params));
+    std::vector<int> accepted(states.size(), 0);
+    
+    // Diagnostics targets: see updateConvergenceReport. Cohort totals are summed
+    // per (chain, block) task for each step of a segment, then across blocks.
+    ConvergenceMonitor monitor(n_chains, 2 * n_individuals + 2);
+    std::vector<double> block_infections(size_t(n_tasks) * interval);
+    std::vector<double> block_log_likelihood(size_t(n_tasks) * interval);
+    
+    report = ConvergenceReport();
+    int steps_run = 0;
+    while (steps_run < max_steps) {
+        int first_step = steps_run;
+        int n_segment = std::min(interval, max_steps - first_step);
+        
+        parallelFor(n_tasks, n_threads, [&](int task) {
+            int chain = task / n_blocks;
+            int block = task % n_blocks;
+            double* infections = block_infections.data() + size_t(task) * interval;
+            double* log_likelihood = block_log_likelihood.data() + size_t(task) * interval;
+            std::fill(infections, infections + n_segment, 0.0);
+            std::fill(log_likelihood, log_likelihood + n_segment, 0.0);
+            
+            int end = std::min(n_individuals, (block + 1) * kParallelBlockSize);
+            for (int i = block * kParallelBlockSize; i < end; i++) {
+                size_t index = size_t(chain) * n_individuals + i;
+                IndividualMCMC& state = states[index];
+                ProposalScales& scales = proposal_scales[index];
+                if (first_step == 0) {
+                    RngStream initial_stream(seed, RngStream::InitialState, unsigned(i), unsigned(chain));
+                    state = dispersedInitialState(initial_stream, individuals[i], ab_params, study_params);
+                }
+                
+                RngStream stream(seed, RngStream::MCMCStep, unsigned(i), unsigned(chain));
+                for (int s = 0; s < n_segment; s++) {
+                    int step = first_step + s;
+                    stream.seekStep(step);
+                    MCMCStep result = mcmcStepIndividual(stream, individuals[i], state, scales,
+                                                         ab_params, study_params);
+                    if (step < burnin) {
+                        scales.adapt(result.move, result.acceptance_rate, step);
+                    }
+                    state = result.params;
+                    if (result.accepted && step >= counted_from) {
+                        accepted[index]++;
+                    }
+                    if (step < burnin) continue;
+                    
+                    monitor.add(chain, i, state.baseline);
+                    monitor.add(chain, n_individuals + i, state.numInfections());
+                    infections[s] += state.numInfections();
+                    log_likelihood[s] += state.log_likelihood;
+                    if ((step - burnin) % thin == 0) {
+                        addSummaryDraw(chain_summaries[chain], i, state);
+                    }
+                }
+            }
+        });
+        
+        // Blocks are summed in a fixed order so totals do not depend on thread timing
+        for (int chain = 0; chain < n_chains; chain++) {
+            for (int s = std::max(0, burnin - first_step); s < n_segment; s++) {
+                double infections = 0.0;
+                double log_likelihood = 0.0;
+                for (int block = 0; block < n_blocks; block++) {
+                    size_t offset = size_t(chain * n_blocks + block) * interval + s;
+                    infections += block_infections[offset];
+                    log_likelihood += block_log_likelihood[offset];
+                }
+                monitor.add(chain, 2 * n_individuals, infections);
+                monitor.add(chain, 2 * n_individuals + 1, log_likelihood);
+            }
+        }
+        
+        steps_run += n_segment;
+        if (steps_run > burnin) {
+            updateConvergenceReport(monitor, options, n_individuals, report);
+            if (report.converged && options.stop_when_converged) break;
+        }
+        if (options.on_check && !options.on_check(steps_run, report)) break;
+    }
+    report.steps_run = steps_run;
+    
+    std::vector<double> acceptance_rates(states.size(), 0.0);
+    int counted_steps = steps_run - counted_from;
+    for (size_t index = 0; index < states.size(); index++) {
+        acceptance_rates[index] = counted_steps > 0 ? double(accepted[index]) / counted_steps : 0.0;
+    }
+    return mergeChainSummaries(chain_summaries, acceptance_rates, proposal_scales);
+}
+
+CohortHandle::CohortHandle(SeroJumpSimulator& simulator_, Cohort cohort_)
+    : simulator(simulator_), cohort(std::move(cohort_)) {
+    int n = cohort.size();
+    views.reserve(n);
+    for (int i = 0; i < n; i++) views.push_back(cohort.individual(i));
+    states.resize(n);
+    scales.resize(n);
+    baselines.resize(n);
+    boosts.resize(n);
+    infection_times.resize(n);
+    log_likelihoods.resize(n);
+    proposal_scales.resize(size_t(n) * 3);
+    infection_counts.resize(n);
+    accepted.assign(n, 0);
+    steps_run.assign(n, 0);
+    squared_residuals.resize(n);
+    population_values.resize(kPopulationValues);
+}
+
+void CohortHandle::setModel(const StudyParams& study_params_, const AntibodyParams& ab_params_, int burnin_) {
+    study_params = study_params_;
+    study_params.n_individuals = size();
+    ab_params = ab_params_;
+    burnin = std::max(0, burnin_);
+    all_infection_times.assign(size_t(size()) * study_params.max_infections, -1.0);
+    
+    for (int i = 0; i < size(); i++) {
+        IndividualMCMC& state = states[i];
+        if (!has_model) {
+            state = simulator.initialState(views[i], ab_params, study_params);
+            scales[i] = ProposalScales::defaults(study_params);
+        } else {
+            // Keep the chain where it is, within the new limits, scored under the new model
+            while (state.numInfections() > study_params.max_infections) {
+                state.infection_times.erase(state.numInfections() - 1);
+            }
+            state.infection_prob_prior = study_params.infection_rate;
+            state.log_likelihood = simulator.logLikelihood(views[i], state, ab_params);
+            state.log_prior = simulator.logPrior(state, ab_params, study_params);
+        }
+        publish(i);
+    }
+    has_model = true;
+    
+    // Population sums from scratch; sampled parameters start from this model
+    titre_kernel::LikelihoodConstants constants(ab_params.observation_sd);
+    population = PopulationSums();
+    for (int i = 0; i < size(); i++) {
+        squared_residuals[i] = constants.sumSquaredResiduals(states[i].log_likelihood, views[i].n_samples);
+        population.add(states[i], squared_residuals[i], views[i].n_samples);
+    }
+    priors.centre = ab_params;
+    publishPopulation();
+}
+
+void CohortHandle::setHierarchical(bool enabled) {
+    hierarchical = enabled;
+}
+
+void CohortHandle::setInfectionHazard(const InfectionHazard& hazard) {
+    study_params.infection_hazard = hazard;
+    if (!has_model) return;
+    for (int i = 0; i < size(); i++) {
+        states[i].log_prior = simulator.logPrior(states[i], ab_params, study_params);
+    }
+}
+
+void CohortHandle::step(int n_steps, int n_threads) {
+    int n = size();
+    trace_length = n_steps;
+    size_t trace_size = size_t(n) * n_steps;
+    trace_baselines.resize(trace_size);
+    trace_boosts.resize(trace_size);
+    trace_infection_times.resize(trace_size);
+    trace_infection_counts.resize(trace_size);
+    trace_log_likelihoods.resize(trace_size);
+    trace_population.resize(hierarchical ? size_t(n_steps) * kPopulationValues : 0);
+    
+    // Each block's change to the population sums is merged in block order, so
+    // the sums do not depend on the thread count
+    int block_size = SeroJumpSimulator::kParallelBlockSize;
+    int n_blocks = (n + block_size - 1) / block_size;
+    std::vector<PopulationSums> deltas(n_blocks);
+    auto sweep = [&](int steps, int trace_column) {
+        parallelFor(n_blocks, n_threads, [&](int block) {
+            deltas[block] = PopulationSums();
+            int end = std::min(n, (block + 1) * block_size);
+            for (int i = block * block_size; i < end; i++) advance(i, steps, trace_column, deltas[block]);
+        });
+        for (const PopulationSums& delta : deltas) population.merge(delta);
+    };
+    
+    if (!hierarchical) {
+        sweep(n_steps, 0);
+        return;
+    }
+    for (int s = 0; s < n_steps; s++) {
+        sweep(1, s);
+        RngStream stream = simulator.makeStream(RngStream::Population, 0);
+        stream.seekStep(population_updates++);
+        simulator.samplePopulation(stream, population, priors, ab_params, study_params);
+        publishPopulation();
+        std::copy(population_values.begin(), population_values.end(),
+                  trace_population.begin() + size_t(s) * kPopulationValues);
+    }
+}
+
+void CohortHandle::stepIndividual(int i, int n_steps) {
+    PopulationSums delta;
+    advance(i, n_steps, -1, delta);
+    population.merge(delta);
+}
+
+void CohortHandle::advance(int i, int n_steps, int trace_column, PopulationSums& delta) {
+    IndividualMCMC& state = states[i];
+    ProposalScales& scale = scales[i];
+    int n_samples = views[i].n_samples;
+    titre_kernel::LikelihoodConstants constants(ab_params.observation_sd);
+    RngStream stream = simulator.makeStream(RngStream::MCMCStep, unsigned(i), 0);
+    size_t row = size_t(i) * trace_length + trace_column;
+    
+    delta.add(state, squared_residuals[i], n_samples, -1.0);
+    if (hierarchical) {
+        // Re-score under the population parameters drawn since this chain's last step
+        state.infection_prob_prior = study_params.infection_rate;
+        state.log_likelihood = constants.logLikelihood(squared_residuals[i], n_samples);
+        state.log_prior = simulator.logPrior(state, ab_params, study_params);
+    }
+    
+    for (int s = 0; s < n_steps; s++) {
+        int step = steps_run[i] + s;
+        stream.seekStep(step);
+        SeroJumpSimulator::MCMCStep result =
+            simulator.mcmcStepIndividual(stream, views[i], state, scale, ab_params, study_params);
+        if (step < burnin) {
+            scale.adapt(result.move, result.acceptance_rate, step);
+        }
+        state = result.params;
+        if (result.accepted && step >= burnin) {
+            accepted[i]++;
+        }
+        if (trace_column >= 0) {
+            trace_baselines[row + s] = state.baseline;
+            trace_boosts[row + s] = state.boost;
+            trace_infection_times[row + s] = state.firstInfectionTime();
+            trace_infection_counts[row + s] = state.numInfections();
+            trace_log_likelihoods[row + s] = state.log_likelihood;
+        }
+    }
+    steps_run[i] += n_steps;
+    squared_residuals[i] = constants.sumSquaredResiduals(state.log_likelihood, n_samples);
+    delta.add(state, squared_residuals[i], n_samples);
+    publish(i);
+}
+
+// Copy chain i's state into the flat arrays
+void CohortHandle::publish(int i) {
+    const IndividualMCMC& state = states[i];
+    baselines[i] = state.baseline;
+    boosts[i] = state.boost;
+    infection_times[i] = state.firstInfectionTime();
+    infection_counts[i] = state.numInfections();
+    log_likelihoods[i] = state.log_likelihood;
+    proposal_scales[3 * i + 0] = scales[i].baseline_step;
+    proposal_scales[3 * i + 1] = scales[i].boost_step;
+    proposal_scales[3 * i + 2] = scales[i].time_step;
+    double* times = all_infection_times.data() + size_t(i) * study_params.max_infections;
+    for (int k = 0; k < study_params.max_infections; k++) {
+        times[k] = k < state.numInfections() ? state.infection_times[k] : -1.0;
+    }
+}
+
+void CohortHandle::publishPopulation() {
+    population_values[0] = ab_params.baseline_mean;
+    population_values[1] = ab_params.baseline_sd;
+    population_values[2] = ab_params.boost_mean;
+    population_values[3] = ab_params.boost_sd;
+    population_values[4] = ab_params.observation_sd;
+    population_values[5] = study_params.infection_rate;
+}
+
+void* CohortHandle::array(Array which, int& length) {
+    int n = size();
+    int traced = n * trace_length;
+    switch (which) {
+        case Baseline: length = n; return baselines.data();
+        case Boost: length = n; return boosts.data();
+        case InfectionTime: length = n; return infection_times.data();
+        case InfectionCount: length = n; return infection_counts.data();
+        case LogLikelihood: length = n; return log_likelihoods.data();
+        case AcceptedCount: length = n; return accepted.data();
+        case StepsRun: length = n; return steps_run.data();
+        case ProposalScale: length = 3 * n; return proposal_scales.data();
+        case AllInfectionTimes: length = int(all_infection_times.size()); return all_infection_times.data();
+        case TraceBaseline: length = traced; return trace_baselines.data();
+        case TraceBoost: length = traced; return trace_boosts.data();
+        case TraceInfectionTime: length = traced; return trace_infection_times.data();
+        case TraceInfectionCount: length = traced; return trace_infection_counts.data();
+        case TraceLogLikelihood: length = traced; return trace_log_likelihoods.data();
+        case Population: length = kPopulationValues; return population_values.data();
+        case TracePopulation: length = int(trace_population.size()); return trace_population.data();
+        default: length = 0; return nullptr;
+    }
+}
+
+namespace {
+
+// Individuals simulate_study produces per chunk
+constexpr int kSimulateChunkSize = 4096;
+
+// A simulated chunk in the C interface's layout: ids repeated per sample, status
+// and true infection time per individual
+void copyChunk(const Cohort& chunk, int* individual_ids, double* sample_times,
+               double* titre_values, double* true_infection_times, int* infection_status) {
+    std::copy(chunk.sample_times.begin(), chunk.sample_times.end(), sample_times);
+    std::copy(chunk.titre_values.begin(), chunk.titre_values.end(), titre_values);
+    for (int i = 0; i < chunk.size(); i++) {
+        std::fill(individual_ids + chunk.offsets[i], individual_ids + chunk.offsets[i + 1], chunk.ids[i]);
+        infection_status[i] = chunk.is_infected[i];
+        true_infection_times[i] = chunk.true_infection_times[i];
+    }
+}
+
+// Flat proposal-scale layout used by the C interface: baseline, boost, time step
+void writeProposalScales(const ProposalScales& scales, double* out) {
+    out[0] = scales.baseline_step;
+    out[1] = scales.boost_step;
+    out[2] = scales.time_step;
+}
+
+// Per-individual summary outputs shared by the streaming exports (see
+// run_mcmc_study_summary); proposal_scales may be NULL
+void writeSummaryOutputs(const PosteriorSummary& summary,
+                         double* baseline_means, double* baseline_sds,
+                         double* boost_means, double* boost_sds,
+                         double* infection_probs,
+                         double* infection_time_means, double* infection_time_sds,
+                         double* infection_time_quantiles,
+                         unsigned int* infection_time_histograms,
+                         double* acceptance_rates, double* proposal_scales) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for (int i = 0; i < summary.n_individuals; i++) {
+        const IndividualSummary& individual = summary.individuals[i];
+        bool any_infected = individual.n_infected > 0;
+        baseline_means[i] = individual.baseline.mean;
+        baseline_sds[i] = individual.baseline.sd();
+        boost_means[i] = any_infected ? individual.boost.mean : nan;
+        boost_sds[i] = any_infected ? individual.boost.sd() : nan;
+        infection_probs[i] = individual.infectionProbability();
+        infection_time_means[i] = any_infected ? individual.infection_time.mean : nan;
+        infection_time_sds[i] = any_infected ? individual.infection_time.sd() : nan;
+        infection_time_quantiles[3 * i + 0] = summary.infectionTimeQuantile(i, 0.025);
+        infection_time_quantiles[3 * i + 1] = summary.infectionTimeQuantile(i, 0.5);
+        infection_time_quantiles[3 * i + 2] = summary.infectionTimeQuantile(i, 0.975);
+        acceptance_rates[i] = summary.acceptance_rates[i];
+        if (proposal_scales) {
+            proposal_scales[3 * i + 0] = summary.baseline_steps[i];
+            proposal_scales[3 * i + 1] = summary.boost_steps[i];
+            proposal_scales[3 * i + 2] = summary.time_steps[i];
+        }
+    }
+    std::copy(summary.infection_time_histograms.begin(), summary.infection_time_histograms.end(),
+              infection_time_histograms);
+}
+
+} // namespace
+
 // C interface functions
 extern "C" {
 
@@ -261,29 +1329,62 @@ int simulate_study(SeroJumpSimulator* simulator,
         baseline_mean, baseline_sd, boost_mean, boost_sd, decay_rate, observation_sd
     };
     
-    auto individuals = simulator->simulateStudy(study_params, ab_params, n_samples_per_individual);
-    
+    // Simulated a chunk at a time straight into the caller's arrays, so no
+    // second copy of the whole cohort is ever held
     int total_samples = 0;
-    for (const auto& individual : individuals) {
-        for (size_t i = 0; i < individual.sample_times.size(); i++) {
-            individual_ids[total_samples] = individual.id;
-            sample_times[total_samples] = individual.sample_times[i];
-            titre_values[total_samples] = individual.titre_values[i];
-            infection_status[individual.id - 1] = individual.is_infected ? 1 : 0;
-            total_samples++;
-        }
-        
-        if (individual.is_infected && !individual.true_infection_times.empty()) {
-            true_infection_times[individual.id - 1] = individual.true_infection_times[0];
-        } else {
-            true_infection_times[individual.id - 1] = -1.0;
-        }
-    }
+    int written = 0;
+    simulator->simulateStudyChunked(study_params, ab_params, n_samples_per_individual,
+                                    kSimulateChunkSize, 1, [&](const Cohort& chunk) {
+        copyChunk(chunk, individual_ids + total_samples, sample_times + total_samples,
+                  titre_values + total_samples, true_infection_times + written,
+                  infection_status + written);
+        total_samples += chunk.totalSamples();
+        written += chunk.size();
+        return true;
+    });
     
     *out_total_samples = total_samples;
     return 1;
 }
 
+StudyStream* create_study_stream(SeroJumpSimulator* simulator,
+                                 double study_start, double study_end, int n_individuals,
+                                 double infection_rate, int n_samples_per_individual,
+                                 double baseline_mean, double baseline_sd,
+                                 double boost_mean, double boost_sd,
+                                 double decay_rate, double observation_sd,
+                                 int chunk_size) {
+    if (!simulator || chunk_size < 1 || n_samples_per_individual < 1) return nullptr;
+    
+    StudyParams study_params = {
+        study_start, study_end, n_individuals, infection_rate, {}
+    };
+    AntibodyParams ab_params = {
+        baseline_mean, baseline_sd, boost_mean, boost_sd, decay_rate, observation_sd
+    };
+    return new StudyStream(*simulator, study_params, ab_params, n_samples_per_individual, chunk_size);
+}
+
+int study_stream_next(StudyStream* stream,
+                      int* individual_ids, double* sample_times, double* titre_values,
+                      double* true_infection_times, int* infection_status,
+                      int* out_total_samples) {
+    if (!stream) return 0;
+    const Cohort* chunk = stream->next();
+    if (!chunk) {
+        *out_total_samples = 0;
+        return 0;
+    }
+    copyChunk(*chunk, individual_ids, sample_times, titre_values, true_infection_times,
+              infection_status);
+    *out_total_samples = chunk->totalSamples();
+    return chunk->size();
+}
+
+void destroy_study_stream(StudyStream* stream) {
+    delete stream;
+}
+
 double compute_titre(double baseline, double boost, double decay_rate,
                     double infection_time, double sample_time) {
     if (sample_time <= infection_time) {
@@ -297,23 +1398,105 @@ double compute_titre(double baseline, double boost, double decay_rate,
 double compute_log_likelihood(int individual_id, double* sample_times, double* titre_values, int n_samples,
                              double baseline, double boost, double decay_rate,
                              double infection_time, int infected_state, double observation_sd) {
-    double log_lik = 0.0;
+    titre_kernel::LikelihoodConstants constants(observation_sd);
+    double ssr = titre_kernel::sumSquaredResiduals(sample_times, titre_values, 0, n_samples,
+                                                   baseline, boost, decay_rate,
+                                                   &infection_time, infected_state ? 1 : 0);
+    return constants.logLikelihood(ssr, n_samples);
+}
+
+CohortHandle* create_cohort_handle(SeroJumpSimulator* simulator,
+                                   int n_individuals, int* individual_ids,
+                                   double* sample_times_all, double* titre_values_all,
+                                   int* n_samples_per_individual) {
+    if (!simulator || n_individuals <= 0) return nullptr;
     
-    for (int i = 0; i < n_samples; i++) {
-        double predicted_titre;
-        
-        if (infected_state) {
-            predicted_titre = compute_titre(baseline, boost, decay_rate, infection_time, sample_times[i]);
-        } else {
-            predicted_titre = baseline;
+    Cohort cohort;
+    int total_samples = 0;
+    for (int i = 0; i < n_individuals; i++) {
+        if (n_samples_per_individual[i] < 1) return nullptr;
+        total_samples += n_samples_per_individual[i];
+    }
+    cohort.reserve(n_individuals, total_samples);
+    cohort.ids.assign(individual_ids, individual_ids + n_individuals);
+    cohort.sample_times.assign(sample_times_all, sample_times_all + total_samples);
+    cohort.titre_values.assign(titre_values_all, titre_values_all + total_samples);
+    for (int i = 0; i < n_individuals; i++) {
+        int offset = cohort.offsets.back();
+        if (!std::is_sorted(sample_times_all + offset, sample_times_all + offset + n_samples_per_individual[i])) {
+            return nullptr;
         }
-        
-        double residual = titre_values[i] - predicted_titre;
-        log_lik += -0.5 * std::log(2.0 * M_PI * observation_sd * observation_sd) 
-                   - 0.5 * (residual * residual) / (observation_sd * observation_sd);
+        cohort.offsets.push_back(offset + n_samples_per_individual[i]);
+    }
+    cohort.true_infection_times.assign(n_individuals, -1.0);
+    cohort.is_infected.assign(n_individuals, 0);
+    cohort.baseline_titres.assign(n_individuals, 0.0);
+    return new CohortHandle(*simulator, std::move(cohort));
+}
+
+int cohort_set_model(CohortHandle* handle,
+                     double study_start, double study_end, double infection_rate,
+                     int max_infections,
+                     double baseline_mean, double baseline_sd, double boost_mean, double boost_sd,
+                     double decay_rate, double observation_sd, int burnin, int gibbs,
+                     int time_grid) {
+    if (!handle || max_infections < 1 || time_grid < 0 || !(study_end > study_start)) return 0;
+    // The checks readModelParams applies to requests; anything else scores every chain NaN
+    if (!(infection_rate > 0.0 && infection_rate < 1.0) || !(decay_rate >= 0.0) ||
+        !(baseline_sd > 0.0) || !(boost_sd > 0.0) || !(observation_sd > 0.0)) {
+        return 0;
     }
     
-    return log_lik;
+    StudyParams study_params = {
+        study_start, study_end, handle->size(), infection_rate, {}
+    };
+    study_params.max_infections = max_infections;
+    study_params.gibbs_parameters = gibbs != 0;
+    study_params.time_grid = time_grid;
+    study_params.infection_hazard = handle->infectionHazard();
+    AntibodyParams ab_params = {
+        baseline_mean, baseline_sd, boost_mean, boost_sd, decay_rate, observation_sd
+    };
+    handle->setModel(study_params, ab_params, burnin);
+    return 1;
+}
+
+int cohort_set_infection_hazard(CohortHandle* handle, int n_intervals, double* hazard) {
+    if (!handle || !handle->hasModel() || n_intervals < 0 || (n_intervals > 0 && !hazard)) return 0;
+    std::vector<double> values(hazard, hazard + n_intervals);
+    if (!InfectionHazard::valid(values)) return 0;
+    handle->setInfectionHazard(InfectionHazard(values));
+    return 1;
+}
+
+int cohort_set_hierarchical(CohortHandle* handle, int enabled) {
+    if (!handle || !handle->hasModel()) return 0;
+    handle->setHierarchical(enabled != 0);
+    return 1;
+}
+
+int cohort_step(CohortHandle* handle, int n_steps, int n_threads) {
+    if (!handle || !handle->hasModel() || n_steps < 0) return 0;
+    handle->step(n_steps, n_threads);
+    return 1;
+}
+
+int cohort_step_individual(CohortHandle* handle, int individual, int n_steps) {
+    if (!handle || !handle->hasModel() || individual < 0 || individual >= handle->size() || n_steps < 0) {
+        return 0;
+    }
+    handle->stepIndividual(individual, n_steps);
+    return 1;
+}
+
+void* cohort_array(CohortHandle* handle, int array, int* out_length) {
+    *out_length = 0;
+    if (!handle || array < 0 || array >= CohortHandle::kNumArrays) return nullptr;
+    return handle->array(CohortHandle::Array(array), *out_length);
+}
+
+void destroy_cohort_handle(CohortHandle* handle) {
+    delete handle;
 }
 
 int mcmc_step_individual(SeroJumpSimulator* simulator,
@@ -330,17 +1513,23 @@ int mcmc_step_individual(SeroJumpSimulator* simulator,
     
     if (!simulator) return 0;
     
-    // Create individual from input data
-    Individual individual;
-    individual.id = individual_id;
-    individual.sample_times.assign(sample_times, sample_times + n_samples);
-    individual.titre_values.assign(titre_values, titre_values + n_samples);
+    // View the caller's sample arrays directly
+    IndividualView individual = { individual_id, sample_times, titre_values, n_samples };
+    if (!std::is_sorted(sample_times, sample_times + n_samples)) return 0;
     
     // Create current MCMC state
-    IndividualMCMC current_params = {
-        current_baseline, current_boost, current_infection_time,
-        current_infected_state != 0, current_log_likelihood, infection_rate
-    };
+    IndividualMCMC current_params;
+    current_params.baseline = current_baseline;
+    current_params.boost = current_boost;
+    // A placeholder boost on an uninfected state would make the prior -inf
+    if (!current_infected_state && !(current_boost > 0.0)) {
+        current_params.boost = (boost_mean > 0.0) ? boost_mean : boost_sd;
+    }
+    if (current_infected_state) {
+        current_params.infection_times.push_back(current_infection_time);
+    }
+    current_params.log_likelihood = current_log_likelihood;
+    current_params.infection_prob_prior = infection_rate;
     
     // Create study parameters
     StudyParams study_params = {
@@ -351,14 +1540,25 @@ int mcmc_step_individual(SeroJumpSimulator* simulator,
         baseline_mean, baseline_sd, boost_mean, boost_sd, decay_rate, observation_sd
     };
     
+    // The caller's cached log-likelihood is trusted when it is finite
+    if (!std::isfinite(current_log_likelihood)) {
+        current_params.log_likelihood = simulator->logLikelihood(individual, current_params, ab_params);
+    }
+    current_params.log_prior = simulator->logPrior(current_params, ab_params, study_params);
+    
+    // Caller's random-walk steps; non-positive values fall back to the defaults
+    ProposalScales scales = ProposalScales::defaults(study_params);
+    if (baseline_step > 0) scales.baseline_step = baseline_step;
+    if (boost_step > 0) scales.boost_step = boost_step;
+    
     // Perform MCMC step
-    auto result = simulator->mcmcStepIndividual(individual, current_params, ab_params, study_params);
+    auto result = simulator->mcmcStepIndividual(individual, current_params, scales, ab_params, study_params);
     
     // Copy results to output
     *new_baseline = result.params.baseline;
     *new_boost = result.params.boost;
-    *new_infection_time = result.params.infection_time;
-    *new_infected_state = result.params.infected_state ? 1 : 0;
+    *new_infection_time = result.params.firstInfectionTime();
+    *new_infected_state = result.params.numInfections();
     *new_log_likelihood = result.params.log_likelihood;
     *accepted = result.accepted ? 1 : 0;
     *acceptance_rate = result.acceptance_rate;
@@ -366,4 +1566,267 @@ int mcmc_step_individual(SeroJumpSimulator* simulator,
     return 1;
 }
 
+int run_mcmc_study(SeroJumpSimulator* simulator,
+                  int n_individuals, int* individual_ids,
+                  double* sample_times_all, double* titre_values_all,
+                  int* n_samples_per_individual,
+                  int n_steps, int burnin, int max_infections,
+                  double study_start, double study_end, double infection_rate,
+                  double baseline_mean, double baseline_sd, double boost_mean, double boost_sd,
+                  double decay_rate, double observation_sd,
+                  double* baseline_chains, double* boost_chains, double* infection_time_chains,
+                  int* infected_state_chains, double* log_likelihood_chains,
+                  double* acceptance_rates, double* proposal_scales) {
+    
+    if (!simulator || n_individuals <= 0 || n_steps <= 0 || max_infections < 1) return 0;
+    
+    StudyParams study_params = {
+        study_start, study_end, n_individuals, infection_rate, {}
+    };
+    study_params.max_infections = max_infections;
+    
+    AntibodyParams ab_params = {
+        baseline_mean, baseline_sd, boost_mean, boost_sd, decay_rate, observation_sd
+    };
+    
+    // The flat sample arrays are read in place (same layout simulate_study produces) and
+    // chains are written straight into the caller's buffers, row-major as [individual][step]
+    int offset = 0;
+    for (int i = 0; i < n_individuals; i++) {
+        IndividualView individual = {
+            individual_ids[i], sample_times_all + offset, titre_values_all + offset,
+            n_samples_per_individual[i]
+        };
+        offset += n_samples_per_individual[i];
+        if (!std::is_sorted(individual.sample_times, individual.sample_times + individual.n_samples)) {
+            return 0;
+        }
+        
+        size_t row = size_t(i) * n_steps;
+        ProposalScales scales = ProposalScales::defaults(study_params);
+        acceptance_rates[i] = simulator->runChainIndividual(
+            individual, ab_params, study_params, n_steps, burnin, scales,
+            [&](int step, const IndividualMCMC& state) {
+                baseline_chains[row + step] = state.baseline;
+                boost_chains[row + step] = state.boost;
+                infection_time_chains[row + step] = state.firstInfectionTime();
+                infected_state_chains[row + step] = state.numInfections();
+                log_likelihood_chains[row + step] = state.log_likelihood;
+            });
+        if (proposal_scales) {
+            writeProposalScales(scales, proposal_scales + size_t(i) * 3);
+        }
+    }
+    
+    return 1;
+}
+
+int run_mcmc_study_parallel(SeroJumpSimulator* simulator,
+                           int n_individuals, int* individual_ids,
+                           double* sample_times_all, double* titre_values_all,
+                           int* n_samples_per_individual,
+                           int n_steps, int burnin, int n_chains, int n_threads,
+                           int max_infections,
+                           double study_start, double study_end, double infection_rate,
+                           double baseline_mean, double baseline_sd, double boost_mean, double boost_sd,
+                           double decay_rate, double observation_sd,
+                           double* baseline_chains, double* boost_chains, double* infection_time_chains,
+                           int* infected_state_chains, double* log_likelihood_chains,
+                           double* acceptance_rates, double* proposal_scales) {
+    
+    if (!simulator || n_individuals <= 0 || n_steps <= 0 || n_chains <= 0 || max_infections < 1) return 0;
+    
+    std::vector<IndividualView> individuals;
+    individuals.reserve(n_individuals);
+    int offset = 0;
+    for (int i = 0; i < n_individuals; i++) {
+        IndividualView individual = {
+            individual_ids[i], sample_times_all + offset, titre_values_all + offset,
+            n_samples_per_individual[i]
+        };
+        offset += n_samples_per_individual[i];
+        if (!std::is_sorted(individual.sample_times, individual.sample_times + individual.n_samples)) {
+            return 0;
+        }
+        individuals.push_back(individual);
+    }
+    
+    StudyParams study_params = {
+        study_start, study_end, n_individuals, infection_rate, {}
+    };
+    study_params.max_infections = max_infections;
+    
+    AntibodyParams ab_params = {
+        baseline_mean, baseline_sd, boost_mean, boost_sd, decay_rate, observation_sd
+    };
+    
+    // Every (chain, individual) row is owned by exactly one worker
+    std::vector<ProposalScales> scales(size_t(n_chains) * n_individuals);
+    simulator->runChainsParallel(
+        individuals, ab_params, study_params, n_steps, burnin, n_chains, n_threads, acceptance_rates,
+        scales.data(),
+        [&](int chain, int i, int step, const IndividualMCMC& state) {
+            size_t index = (size_t(chain) * n_individuals + i) * n_steps + step;
+            baseline_chains[index] = state.baseline;
+            boost_chains[index] = state.boost;
+            infection_time_chains[index] = state.firstInfectionTime();
+            infected_state_chains[index] = state.numInfections();
+            log_likelihood_chains[index] = state.log_likelihood;
+        });
+    
+    if (proposal_scales) {
+        for (size_t index = 0; index < scales.size(); index++) {
+            writeProposalScales(scales[index], proposal_scales + index * 3);
+        }
+    }
+    
+    return 1;
+}
+
+int run_mcmc_study_summary(SeroJumpSimulator* simulator,
+                          int n_individuals, int* individual_ids,
+                          double* sample_times_all, double* titre_values_all,
+                          int* n_samples_per_individual,
+                          int n_steps, int burnin, int thin, int n_chains, int n_threads,
+                          int max_infections,
+                          double study_start, double study_end, double infection_rate,
+                          double baseline_mean, double baseline_sd, double boost_mean, double boost_sd,
+                          double decay_rate, double observation_sd,
+                          int n_bins,
+                          double* baseline_means, double* baseline_sds,
+                          double* boost_means, double* boost_sds,
+                          double* infection_probs,
+                          double* infection_time_means, double* infection_time_sds,
+                          double* infection_time_quantiles,
+                          unsigned int* infection_time_histograms,
+                          double* acceptance_rates, double* proposal_scales) {
+    
+    if (!simulator || n_individuals <= 0 || n_steps <= 0 || n_chains <= 0 || n_bins <= 0 ||
+        max_infections < 1) return 0;
+    
+    std::vector<IndividualView> individuals;
+    individuals.reserve(n_individuals);
+    int offset = 0;
+    for (int i = 0; i < n_individuals; i++) {
+        IndividualView individual = {
+            individual_ids[i], sample_times_all + offset, titre_values_all + offset,
+            n_samples_per_individual[i]
+        };
+        offset += n_samples_per_individual[i];
+        if (!std::is_sorted(individual.sample_times, individual.sample_times + individual.n_samples)) {
+            return 0;
+        }
+        individuals.push_back(individual);
+    }
+    
+    StudyParams study_params = {
+        study_start, study_end, n_individuals, infection_rate, {}
+    };
+    study_params.max_infections = max_infections;
+    
+    AntibodyParams ab_params = {
+        baseline_mean, baseline_sd, boost_mean, boost_sd, decay_rate, observation_sd
+    };
+    
+    PosteriorSummary summary = simulator->runMCMCStudySummary(
+        individuals, ab_params, study_params, n_steps, burnin, thin, n_bins, n_chains, n_threads);
+    writeSummaryOutputs(summary, baseline_means, baseline_sds, boost_means, boost_sds,
+                        infection_probs, infection_time_means, infection_time_sds,
+                        infection_time_quantiles, infection_time_histograms,
+                        acceptance_rates, proposal_scales);
+    
+    return 1;
+}
+
+int run_mcmc_study_until_converged(SeroJumpSimulator* simulator,
+                                   int n_individuals, int* individual_ids,
+                                   double* sample_times_all, double* titre_values_all,
+                                   int* n_samples_per_individual,
+                                   int max_steps, int burnin, int thin, int n_chains, int n_threads,
+                                   int max_infections,
+                                   int check_interval, double max_rhat, double min_ess,
+                                   int stop_when_converged,
+                                   double study_start, double study_end, double infection_rate,
+                                   double baseline_mean, double baseline_sd, double boost_mean, double boost_sd,
+                                   double decay_rate, double observation_sd,
+                                   int n_bins,
+                                   double* baseline_means, double* baseline_sds,
+                                   double* boost_means, double* boost_sds,
+                                   double* infection_probs,
+                                   double* infection_time_means, double* infection_time_sds,
+                                   double* infection_time_quantiles,
+                                   unsigned int* infection_time_histograms,
+                                   double* acceptance_rates, double* proposal_scales,
+                                   double* baseline_rhats, double* baseline_ess,
+                                   double* infection_rhats, double* infection_ess,
+                                   double* study_diagnostics,
+                                   int* laggards, int* n_laggards,
+                                   int* steps_run, int* converged) {
+    
+    if (!simulator || n_individuals <= 0 || max_steps <= 0 || n_chains <= 0 || n_bins <= 0 ||
+        max_infections < 1) return 0;
+    
+    std::vector<IndividualView> individuals;
+    individuals.reserve(n_individuals);
+    int offset = 0;
+    for (int i = 0; i < n_individuals; i++) {
+        IndividualView individual = {
+            individual_ids[i], sample_times_all + offset, titre_values_all + offset,
+            n_samples_per_individual[i]
+        };
+        offset += n_samples_per_individual[i];
+        if (!std::is_sorted(individual.sample_times, individual.sample_times + individual.n_samples)) {
+            return 0;
+        }
+        individuals.push_back(individual);
+    }
+    
+    StudyParams study_params = {
+        study_start, study_end, n_individuals, infection_rate, {}
+    };
+    study_params.max_infections = max_infections;
+    
+    AntibodyParams ab_params = {
+        baseline_mean, baseline_sd, boost_mean, boost_sd, decay_rate, observation_sd
+    };
+    
+    ConvergenceOptions options;
+    options.check_interval = check_interval;
+    options.max_rhat = max_rhat;
+    options.min_ess = min_ess;
+    options.stop_when_converged = stop_when_converged != 0;
+    
+    ConvergenceReport report;
+    PosteriorSummary summary = simulator->runMCMCStudySummary(
+        individuals, ab_params, study_params, max_steps, burnin, thin, n_bins, n_chains, n_threads,
+        options, report);
+    writeSummaryOutputs(summary, baseline_means, baseline_sds, boost_means, boost_sds,
+                        infection_probs, infection_time_means, infection_time_sds,
+                        infection_time_quantiles, infection_time_histograms,
+                        acceptance_rates, proposal_scales);
+    
+    // The report is empty when the run never got past burn-in
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    bool diagnosed = !report.baseline_rhat.empty();
+    for (int i = 0; i < n_individuals; i++) {
+        baseline_rhats[i] = diagnosed ? report.baseline_rhat[i] : nan;
+        baseline_ess[i] = diagnosed ? report.baseline_ess[i] : nan;
+        infection_rhats[i] = diagnosed ? report.infection_rhat[i] : nan;
+        infection_ess[i] = diagnosed ? report.infection_ess[i] : nan;
+    }
+    study_diagnostics[0] = report.total_infections_rhat;
+    study_diagnostics[1] = report.total_infections_ess;
+    study_diagnostics[2] = report.log_likelihood_rhat;
+    study_diagnostics[3] = report.log_likelihood_ess;
+    std::copy(report.laggards.begin(), report.laggards.end(), laggards);
+    *n_laggards = diagnosed ? int(report.laggards.size()) : n_individuals;
+    if (!diagnosed) {
+        for (int i = 0; i < n_individuals; i++) laggards[i] = i;
+    }
+    *steps_run = report.steps_run;
+    *converged = report.converged ? 1 : 0;
+    
+    return 1;
+}
+
 } // extern "C"
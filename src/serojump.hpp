@@ -1,20 +1,57 @@
 #pragma once
 #include <vector>
-#include <random>
+#include <cstdint>
 #include <cmath>
 #include <array>
 #include <memory>
 #include <algorithm>
+#include "parallel.hpp"
+#include "posterior_summary.hpp"
+#include "convergence.hpp"
+#include "small_vector.hpp"
+#include "metrics.hpp"
+#include "philox.hpp"
+#include "infection_hazard.hpp"
 
-// Individual antibody trajectory data structure
-struct Individual {
+// Read-only view of one individual's samples inside a Cohort (or any
+// caller-owned flat arrays)
+struct IndividualView {
     int id;
+    const double* sample_times;            // times when samples were taken
+    const double* titre_values;            // observed IgG titre values
+    int n_samples;                         // sample_times must be ascending
+};
+
+// Structure-of-arrays cohort storage. Samples for all individuals live in
+// contiguous arrays; individual i owns [offsets[i], offsets[i + 1]). This is
+// the same flat layout simulate_study exports.
+struct Cohort {
+    std::vector<int> ids;
+    std::vector<int> offsets{0};           // size() + 1 entries
     std::vector<double> sample_times;      // times when samples were taken
     std::vector<double> titre_values;      // observed IgG titre values
-    std::vector<double> true_infection_times; // true infection times (for simulation)
-    bool is_infected;                      // true infection status
-    double infection_prob;                 // fitted probability of infection
-    double baseline_titre;                 // baseline antibody level
+    std::vector<double> true_infection_times; // true infection time per individual, -1 if none
+    std::vector<unsigned char> is_infected;   // true infection status
+    std::vector<double> baseline_titres;   // true baseline antibody level
+    
+    int size() const { return int(ids.size()); }
+    int totalSamples() const { return offsets.back(); }
+    int numSamples(int i) const { return offsets[i + 1] - offsets[i]; }
+    
+    IndividualView individual(int i) const {
+        return { ids[i], sample_times.data() + offsets[i],
+                 titre_values.data() + offsets[i], numSamples(i) };
+    }
+    
+    void reserve(int n_individuals, int n_samples_total) {
+        ids.reserve(n_individuals);
+        offsets.reserve(n_individuals + 1);
+        true_infection_times.reserve(n_individuals);
+        is_infected.reserve(n_individuals);
+        baseline_titres.reserve(n_individuals);
+        sample_times.reserve(n_samples_total);
+        titre_values.reserve(n_samples_total);
+    }
 };
 
 // Parameters for antibody kinetics model
@@ -27,14 +64,23 @@ struct AntibodyParams {
     double observation_sd;    // measurement noise
 };
 
+// Ascending infection times of one individual; stored inline for up to four
+// infections, so copying a state for a proposal does not allocate
+typedef SmallVector<double, 4> InfectionTimes;
+
 // MCMC parameters for an individual
 struct IndividualMCMC {
     double baseline;          // individual baseline titre
-    double boost;            // titre boost from infection
-    double infection_time;   // proposed infection time
-    bool infected_state;     // current infection state
+    double boost;            // titre boost per infection
+    InfectionTimes infection_times; // ascending infection times (empty = uninfected)
     double log_likelihood;   // current log-likelihood
     double infection_prob_prior; // prior probability of infection
+    double log_prior;        // current log-prior (cached alongside log_likelihood)
+    
+    bool infected() const { return !infection_times.empty(); }
+    int numInfections() const { return infection_times.size(); }
+    // Earliest infection time, or -1 when uninfected (simulate_study's convention)
+    double firstInfectionTime() const { return infected() ? infection_times.front() : -1.0; }
 };
 
 // Study-wide parameters  
@@ -43,76 +89,692 @@ struct StudyParams {
     double study_end;        // study end time
     int n_individuals;       // number of individuals
     double infection_rate;   // population infection rate
-    std::vector<double> infection_hazard; // time-varying infection hazard
+    InfectionHazard infection_hazard; // shape of infection times over the window (empty = uniform)
+    int max_infections = 1;  // most infections per individual (1 = infected/uninfected)
+    bool gibbs_parameters = false; // draw baseline and boost exactly, times collapsed over them
+    int time_grid = 0;       // > 0: infection-time moves propose from a grid of this many cells
+};
+
+// Running sums over individual states from which the population parameters'
+// conditionals follow. They are kept up to date as states change (add with
+// weight -1 takes a state out), so a population update needs no cohort pass.
+struct PopulationSums {
+    double individuals = 0.0;
+    double sum_baseline = 0.0;
+    double sum_baseline_sq = 0.0;
+    double sum_boost = 0.0;
+    double sum_boost_sq = 0.0;
+    double uninfected = 0.0;
+    double infected = 0.0;
+    double extra_infections = 0.0;          // infections past each individual's first
+    double samples = 0.0;
+    double sum_squared_residuals = 0.0;     // observation residuals, all samples
+    
+    void add(const IndividualMCMC& state, double squared_residuals, int n_samples, double weight = 1.0) {
+        int k = state.numInfections();
+        individuals += weight;
+        sum_baseline += weight * state.baseline;
+        sum_baseline_sq += weight * state.baseline * state.baseline;
+        sum_boost += weight * state.boost;
+        sum_boost_sq += weight * state.boost * state.boost;
+        if (k == 0) {
+            uninfected += weight;
+        } else {
+            infected += weight;
+            extra_infections += weight * (k - 1);
+        }
+        samples += weight * n_samples;
+        sum_squared_residuals += weight * squared_residuals;
+    }
+    
+    void merge(const PopulationSums& other) {
+        individuals += other.individuals;
+        sum_baseline += other.sum_baseline;
+        sum_baseline_sq += other.sum_baseline_sq;
+        sum_boost += other.sum_boost;
+        sum_boost_sq += other.sum_boost_sq;
+        uninfected += other.uninfected;
+        infected += other.infected;
+        extra_infections += other.extra_infections;
+        samples += other.samples;
+        sum_squared_residuals += other.sum_squared_residuals;
+    }
+};
+
+// Priors of the population parameters when they are sampled: normal on
+// baseline_mean and boost_mean, inverse-gamma on the baseline, boost and
+// observation variances, beta on infection_rate. decay_rate stays fixed, as
+// its likelihood does not reduce to running sums.
+struct HyperPriors {
+    AntibodyParams centre{};        // prior means of the two means and three variances
+    double mean_sd = 10.0;          // sd of the priors on the means
+    double variance_shape = 2.0;    // inverse-gamma shape; the scale puts the mean at centre
+    double rate_alpha = 1.0;
+    double rate_beta = 1.0;
+};
+
+// Reversible-jump move types; Gibbs replaces Parameters when
+// StudyParams::gibbs_parameters is set
+enum class MoveType { Parameters, InfectionTime, Birth, Death, Gibbs };
+
+// Process-wide proposal and acceptance counts per move type, updated by every
+// mcmcStepIndividual call (sharded, so parallel chains do not contend)
+struct MCMCCounters {
+    static constexpr int kMoves = 5;
+    metrics::Counter proposed[kMoves];
+    metrics::Counter accepted[kMoves];
+};
+MCMCCounters& mcmcCounters();
+const char* moveTypeName(MoveType move);
+
+// Random-walk step sizes of one individual's chain. During burn-in they are
+// tuned by Robbins-Monro on the log scale toward a target acceptance rate;
+// afterwards they are frozen so the kept draws come from a fixed kernel.
+struct ProposalScales {
+    double baseline_step;
+    double boost_step;      // scaled together with baseline_step (joint move)
+    double time_step;       // infection-time shift
+    
+    // Near-optimal rates for a 2-d and a 1-d Gaussian random walk
+    static constexpr double kTargetParameters = 0.35;
+    static constexpr double kTargetInfectionTime = 0.44;
+    
+    // The fixed steps used before adaptation existed
+    static ProposalScales defaults(const StudyParams& study_params) {
+        return { 0.1, 0.2, (study_params.study_end - study_params.study_start) * 0.1 };
+    }
+    
+    // Move log(step) by gain * (acceptance - target), gain = (iteration + 1)^-0.6
+    void adapt(MoveType move, double acceptance_rate, int iteration) {
+        double gain = std::pow(iteration + 1.0, -0.6);
+        if (move == MoveType::Parameters) {
+            double factor = std::exp(gain * (acceptance_rate - kTargetParameters));
+            baseline_step = clampStep(baseline_step * factor);
+            boost_step = clampStep(boost_step * factor);
+        } else if (move == MoveType::InfectionTime) {
+            time_step = clampStep(time_step * std::exp(gain * (acceptance_rate - kTargetInfectionTime)));
+        }
+    }
+    
+private:
+    static double clampStep(double step) { return std::min(std::max(step, 1e-6), 1e6); }
+};
+
+// Counter-based random stream (Philox4x32-10, see philox.hpp). Draw n of the
+// stream (seed, purpose, a, b) is a pure function of those values, so streams
+// cost nothing to create, need no shared state, and give the same numbers on
+// whichever thread consumes them. Uniforms come two per Philox block and are
+// generated a few blocks at a time; normals use Box-Muller in pairs.
+class RngStream {
+public:
+    // What a stream is for; a and b identify it within that purpose
+    enum Purpose : uint32_t {
+        Sequential = 0,     // the simulator's own stream
+        Simulation = 1,     // a = individual id
+        InitialState = 2,   // a = individual index, b = chain
+        MCMCStep = 3,       // a = individual index, b = chain; seekStep per step
+        SerialChain = 4,    // a = individual id, b = chain number
+        Population = 5      // a = chain; seekStep per population update
+    };
+    
+    explicit RngStream(unsigned seed, uint32_t purpose = Sequential, uint32_t a = 0, uint32_t b = 0)
+        : key{ seed, purpose }, id{ a, b } {}
+    
+    // Jump to the draws reserved for MCMC step `step` (kStepBlocks blocks each),
+    // so a chain's numbers depend only on its step count, not on how the run
+    // was split into segments or tasks
+    void seekStep(int step) {
+        position = uint64_t(step) * kStepBlocks;
+        next = kBuffered;
+        has_spare = false;
+    }
+    
+    double uniform() {
+        if (next == kBuffered) refill();
+        return buffer[next++];
+    }
+    
+    double normal() {
+        if (has_spare) {
+            has_spare = false;
+            return spare;
+        }
+        double u1 = uniform();
+        double u2 = uniform();
+        double z0;
+        philox::boxMuller(u1, u2, z0, spare);
+        has_spare = true;
+        return z0;
+    }
+    
+    // n draws at once; the same values n calls of uniform() would return
+    void uniforms(double* out, int n) {
+        int i = 0;
+        while (i < n && next < kBuffered) out[i++] = buffer[next++];
+        int n_blocks = (n - i) / 2;
+        philox::uniforms(key[0], key[1], id[0], id[1], position, n_blocks, out + i);
+        position += uint64_t(n_blocks);
+        i += 2 * n_blocks;
+        if (i < n) out[i] = uniform();
+    }
+    
+    // n draws at once; the same values n calls of normal() would return
+    void normals(double* out, int n) {
+        int i = 0;
+        if (n > 0 && has_spare) {
+            out[i++] = spare;
+            has_spare = false;
+        }
+        double pairs[kBatch];
+        while (i < n) {
+            int n_pairs = std::min((n - i + 1) / 2, kBatch / 2);
+            uniforms(pairs, 2 * n_pairs);
+            for (int p = 0; p < n_pairs; p++) {
+                double z0, z1;
+                philox::boxMuller(pairs[2 * p], pairs[2 * p + 1], z0, z1);
+                out[i++] = z0;
+                if (i < n) {
+                    out[i++] = z1;
+                } else {
+                    spare = z1;
+                    has_spare = true;
+                }
+            }
+        }
+    }
+    
+    static constexpr uint64_t kStepBlocks = 1u << 16;
+    
+private:
+    static constexpr int kBuffered = 4;     // uniforms per refill (two blocks)
+    static constexpr int kBatch = 64;       // uniforms per Box-Muller batch
+    
+    void refill() {
+        philox::uniforms(key[0], key[1], id[0], id[1], position, kBuffered / 2, buffer);
+        position += kBuffered / 2;
+        next = 0;
+    }
+    
+    uint32_t key[2];
+    uint32_t id[2];
+    uint64_t position = 0;                  // next Philox block
+    double buffer[kBuffered];
+    int next = kBuffered;
+    double spare = 0.0;
+    bool has_spare = false;
 };
 
 class SeroJumpSimulator {
 private:
-    std::mt19937 rng;
-    std::normal_distribution<double> normal_dist;
-    std::uniform_real_distribution<double> uniform_dist;
+    unsigned seed;
+    RngStream rng;
+    unsigned serial_chains = 0;     // chains run from the simulator's own stream so far
     
     // Antibody kinetics function
     double computeTitre(double baseline, double boost, double decay_rate, 
                        double infection_time, double sample_time);
     
-    // Log-likelihood calculation
-    double logLikelihood(const Individual& individual, const IndividualMCMC& params,
-                        const AntibodyParams& study_params);
-    
     // Prior probabilities
     double logPriorBaseline(double baseline, const AntibodyParams& params);
     double logPriorBoost(double boost, const AntibodyParams& params);  
-    double logPriorInfection(bool infected, double infection_time, 
-                           const StudyParams& study_params);
+    // Number of infections (P(0) = 1 - rate, P(k | k >= 1) proportional to
+    // rate^(k-1) up to max_infections) and their ordered times (density from the hazard)
+    double logPriorInfections(const InfectionTimes& infection_times,
+                             const StudyParams& study_params);
+    
+    // Replace state's baseline and boost with an exact draw given its infection
+    // times, re-scoring it
+    void drawParameters(RngStream& stream, const IndividualView& individual, IndividualMCMC& state,
+                        const AntibodyParams& ab_params, const StudyParams& study_params);
+    
+    // Draw one individual's truth and n_samples samples from stream into the
+    // given slots of a cohort
+    void drawIndividual(RngStream& stream, const StudyParams& study_params,
+                        const AntibodyParams& ab_params, int n_samples,
+                        unsigned char& is_infected, double& infection_time, double& baseline_titre,
+                        double* sample_times, double* titre_values);
 
 public:
     SeroJumpSimulator(unsigned seed = 12345);
     
-    // Simulation methods
-    std::vector<Individual> simulateStudy(const StudyParams& study_params,
-                                         const AntibodyParams& ab_params,
-                                         int n_samples_per_individual);
+    // A stream of this simulator's seed (see RngStream::Purpose)
+    RngStream makeStream(uint32_t purpose, uint32_t a, uint32_t b = 0) const {
+        return RngStream(seed, purpose, a, b);
+    }
+    
+    // Log-likelihood calculation
+    double logLikelihood(const IndividualView& individual, const IndividualMCMC& params,
+                        const AntibodyParams& study_params);
+    
+    // Log-likelihood contribution of samples [first_sample, n_samples) only
+    double logLikelihoodFrom(const IndividualView& individual, const IndividualMCMC& params,
+                            const AntibodyParams& study_params, int first_sample);
+    
+    // Joint log-prior of an individual's state
+    double logPrior(const IndividualMCMC& params, const AntibodyParams& ab_params,
+                   const StudyParams& study_params);
+    
+    // Simulation methods. Individual i draws from its own stream keyed on
+    // (seed, id i + 1), so the cohort is identical at any thread count and
+    // however it is split into chunks.
+    Cohort simulateStudy(const StudyParams& study_params,
+                        const AntibodyParams& ab_params,
+                        int n_samples_per_individual, int n_threads = 1);
     
-    Individual simulateIndividual(int id, const StudyParams& study_params,
-                                 const AntibodyParams& ab_params,
-                                 int n_samples);
+    // Individuals [first, first + count) of the study, filled in parallel into
+    // chunk, whose storage is reused from call to call
+    void simulateChunk(const StudyParams& study_params, const AntibodyParams& ab_params,
+                       int n_samples_per_individual, int first, int count,
+                       Cohort& chunk, int n_threads = 1);
+    
+    // The whole study handed to consume(const Cohort& chunk) chunk_size
+    // individuals at a time, so memory stays at one chunk whatever the cohort
+    // size. consume returns false to stop early; returns whether every chunk
+    // was consumed.
+    template <typename Consumer>
+    bool simulateStudyChunked(const StudyParams& study_params, const AntibodyParams& ab_params,
+                              int n_samples_per_individual, int chunk_size, int n_threads,
+                              Consumer&& consume);
+    
+    // Append one simulated individual to the cohort; the same draws simulateStudy
+    // makes for this id
+    void simulateIndividual(Cohort& cohort, int id, const StudyParams& study_params,
+                           const AntibodyParams& ab_params,
+                           int n_samples);
     
     // MCMC methods
     struct MCMCStep {
         IndividualMCMC params;
         bool accepted;
         double acceptance_rate;
+        MoveType move;
     };
     
-    MCMCStep mcmcStepIndividual(const Individual& individual,
+    // current_params.log_likelihood and log_prior must be up to date for the
+    // current state; only the proposal is scored. The overloads without a
+    // stream draw from the simulator's own stream, and the one without scales
+    // uses ProposalScales::defaults.
+    MCMCStep mcmcStepIndividual(const IndividualView& individual,
                                const IndividualMCMC& current_params,
                                const AntibodyParams& study_params,
                                const StudyParams& study_settings);
     
-    // Parameter proposal methods
-    IndividualMCMC proposeParameters(const IndividualMCMC& current,
-                                   double baseline_step, double boost_step);
+    MCMCStep mcmcStepIndividual(const IndividualView& individual,
+                               const IndividualMCMC& current_params,
+                               const ProposalScales& scales,
+                               const AntibodyParams& study_params,
+                               const StudyParams& study_settings);
     
-    IndividualMCMC proposeInfectionTime(const IndividualMCMC& current,
-                                       const StudyParams& study_params);
+    MCMCStep mcmcStepIndividual(RngStream& stream, const IndividualView& individual,
+                               const IndividualMCMC& current_params,
+                               const ProposalScales& scales,
+                               const AntibodyParams& study_params,
+                               const StudyParams& study_settings);
     
-    IndividualMCMC proposeInfectionState(const IndividualMCMC& current);
+    // Reversible-jump proposals. Each returns the proposed state, the time
+    // at or before which predicted titres are unchanged, and the log Hastings
+    // ratio log q(current | proposed) - log q(proposed | current).
+    struct Proposal {
+        IndividualMCMC params;
+        double changed_from;
+        double log_hastings;
+    };
+    
+    // Exact joint draw of baseline and boost given the infection times from
+    // their bivariate normal conditional (boost > 0), computed from the
+    // samples' sufficient statistics; always accepted
+    MCMCStep gibbsParameters(RngStream& stream, const IndividualView& individual,
+                             const IndividualMCMC& current, const AntibodyParams& ab_params,
+                             const StudyParams& study_params);
+    
+    // Log-likelihood of the infection times with baseline and boost integrated
+    // out against their priors; Gibbs mode accepts time moves on this
+    double logMarginalLikelihood(const IndividualView& individual,
+                                 const InfectionTimes& infection_times,
+                                 const AntibodyParams& ab_params);
+    
+    // Gibbs mode's shift, birth or death: accepted on the marginal likelihood
+    // of the proposed times, then baseline and boost are drawn given them, so
+    // whether a move is taken does not hinge on parameters fitted to the old times
+    MCMCStep collapsedTimeMove(RngStream& stream, const IndividualView& individual,
+                               const IndividualMCMC& current_params, const Proposal& proposal,
+                               MoveType move, const AntibodyParams& ab_params,
+                               const StudyParams& study_params);
+    
+    // Random walk on baseline and boost
+    Proposal proposeParameters(RngStream& stream, const IndividualMCMC& current,
+                               double baseline_step, double boost_step);
+    
+    // Shift one infection time (reflected random walk within the study window)
+    Proposal proposeInfectionTime(RngStream& stream, const IndividualMCMC& current,
+                                  double time_step, const StudyParams& study_params);
+    
+    // Move one infection time to a draw from study_params.time_grid cells
+    // weighted by the likelihood at their midpoints (all scored in one pass),
+    // uniform within the cell. The Hastings ratio makes the continuous
+    // posterior exact; with cells narrow next to the likelihood's features
+    // nearly every proposal is accepted, however far apart its modes lie.
+    Proposal proposeGridTime(RngStream& stream, const IndividualView& individual,
+                             const IndividualMCMC& current, const AntibodyParams& ab_params,
+                             const StudyParams& study_params);
+    
+    // Birth: add an infection at a time drawn from the hazard. Death: remove a random one.
+    Proposal proposeBirth(RngStream& stream, const IndividualMCMC& current,
+                          const StudyParams& study_params);
+    Proposal proposeDeath(RngStream& stream, const IndividualMCMC& current,
+                          const StudyParams& study_params);
+    
+    // Starting state for a chain: uninfected at the population means
+    IndividualMCMC initialState(const IndividualView& individual,
+                               const AntibodyParams& ab_params,
+                               const StudyParams& study_params);
+    
+    // One Gibbs update of the population parameters from the running sums:
+    // baseline and boost means then sds, observation sd and infection_rate.
+    // The boost's truncation at 0 and the infection-count normaliser (for
+    // max_infections > 1) are corrected for by Metropolis-Hastings. Costs O(1)
+    // in the cohort size.
+    void samplePopulation(RngStream& stream, const PopulationSums& sums, const HyperPriors& priors,
+                          AntibodyParams& ab_params, StudyParams& study_params);
+    
+    // Starting state drawn from the prior, so that parallel chains start dispersed
+    IndividualMCMC dispersedInitialState(RngStream& stream, const IndividualView& individual,
+                                        const AntibodyParams& ab_params,
+                                        const StudyParams& study_params);
     
     // Full MCMC chain for multiple individuals
     struct MCMCResults {
         std::vector<std::vector<IndividualMCMC>> chains; // [individual][step]
         std::vector<double> acceptance_rates;
+        std::vector<ProposalScales> proposal_scales;     // adapted during burn-in
         int total_steps;
         int burnin_steps;
     };
     
-    MCMCResults runMCMCStudy(const std::vector<Individual>& individuals,
+    MCMCResults runMCMCStudy(const Cohort& cohort,
                            const AntibodyParams& ab_params,
                            const StudyParams& study_params,
                            int n_steps, int burnin);
+    
+    // Independent chains for the whole cohort on a pool of threads; one
+    // MCMCResults per chain. n_threads <= 0 uses every hardware thread.
+    std::vector<MCMCResults> runMCMCStudyParallel(const Cohort& cohort,
+                                                  const AntibodyParams& ab_params,
+                                                  const StudyParams& study_params,
+                                                  int n_steps, int burnin,
+                                                  int n_chains, int n_threads);
+    
+    // Streaming alternative to runMCMCStudyParallel: every thin-th post-burn-in
+    // draw of each chain is folded into online accumulators (merged across
+    // chains) and no chain is stored. Infection-time histograms use n_bins
+    // bins over the study window.
+    PosteriorSummary runMCMCStudySummary(const Cohort& cohort,
+                                         const AntibodyParams& ab_params,
+                                         const StudyParams& study_params,
+                                         int n_steps, int burnin, int thin, int n_bins,
+                                         int n_chains, int n_threads);
+    
+    PosteriorSummary runMCMCStudySummary(const std::vector<IndividualView>& individuals,
+                                         const AntibodyParams& ab_params,
+                                         const StudyParams& study_params,
+                                         int n_steps, int burnin, int thin, int n_bins,
+                                         int n_chains, int n_threads);
+    
+    // Streaming run that monitors split-R-hat and ESS online. All chains
+    // advance options.check_interval steps at a time; after burn-in each pause
+    // updates report, and with options.stop_when_converged the run ends at the
+    // first check where every target meets the thresholds (otherwise after
+    // max_steps). Draws are keyed on (chain, individual, step) as in
+    // runChainsParallel, so chains match the unmonitored run step for step.
+    PosteriorSummary runMCMCStudySummary(const std::vector<IndividualView>& individuals,
+                                         const AntibodyParams& ab_params,
+                                         const StudyParams& study_params,
+                                         int max_steps, int burnin, int thin, int n_bins,
+                                         int n_chains, int n_threads,
+                                         const ConvergenceOptions& options,
+                                         ConvergenceReport& report);
+    
+    // Run a single individual's chain for n_steps from initial_state, handing
+    // each state to record(step, state). Step s draws from stream.seekStep(s).
+    // scales holds the starting proposal scales and receives the ones adapted
+    // over the burn-in steps. Returns the post-burn-in acceptance rate.
+    template <typename Recorder>
+    double runChainIndividual(RngStream& stream, const IndividualView& individual,
+                              const IndividualMCMC& initial_state,
+                              const AntibodyParams& ab_params,
+                              const StudyParams& study_params,
+                              int n_steps, int burnin, ProposalScales& scales,
+                              Recorder&& record);
+    
+    // Same, from initialState(); every call runs a new chain with its own stream
+    template <typename Recorder>
+    double runChainIndividual(const IndividualView& individual,
+                              const AntibodyParams& ab_params,
+                              const StudyParams& study_params,
+                              int n_steps, int burnin, ProposalScales& scales,
+                              Recorder&& record) {
+        RngStream stream(seed, RngStream::SerialChain, unsigned(individual.id), serial_chains++);
+        return runChainIndividual(stream, individual, initialState(individual, ab_params, study_params),
+                                  ab_params, study_params, n_steps, burnin, scales,
+                                  std::forward<Recorder>(record));
+    }
+    
+    // Individuals are processed in fixed-size blocks for scheduling, but every
+    // (chain, individual) has its own streams keyed on its index, so results
+    // are identical at any thread count and block size.
+    static constexpr int kParallelBlockSize = 64;
+    
+    // Run n_chains chains for every individual across n_threads workers.
+    // record(chain, individual, step, state) is called concurrently for
+    // different individuals; acceptance_rates and proposal_scales are laid
+    // out [chain][individual].
+    template <typename Recorder>
+    void runChainsParallel(const std::vector<IndividualView>& individuals,
+                           const AntibodyParams& ab_params,
+                           const StudyParams& study_params,
+                           int n_steps, int burnin, int n_chains, int n_threads,
+                           double* acceptance_rates, ProposalScales* proposal_scales,
+                           Recorder&& record);
+};
+
+template <typename Recorder>
+double SeroJumpSimulator::runChainIndividual(RngStream& stream, const IndividualView& individual,
+                                             const IndividualMCMC& initial_state,
+                                             const AntibodyParams& ab_params,
+                                             const StudyParams& study_params,
+                                             int n_steps, int burnin, ProposalScales& scales,
+                                             Recorder&& record) {
+    // Acceptance is only counted after burn-in (or over the whole run if it is all burn-in)
+    int counted_from = (burnin < n_steps) ? burnin : 0;
+    int counted_steps = n_steps - counted_from;
+    int n_accepted = 0;
+    
+    IndividualMCMC state = initial_state;
+    for (int step = 0; step < n_steps; step++) {
+        stream.seekStep(step);
+        MCMCStep result = mcmcStepIndividual(stream, individual, state, scales, ab_params, study_params);
+        if (step < burnin) {
+            scales.adapt(result.move, result.acceptance_rate, step);
+        }
+        state = result.params;
+        if (result.accepted && step >= counted_from) {
+            n_accepted++;
+        }
+        record(step, state);
+    }
+    
+    return counted_steps > 0 ? double(n_accepted) / counted_steps : 0.0;
+}
+
+template <typename Recorder>
+void SeroJumpSimulator::runChainsParallel(const std::vector<IndividualView>& individuals,
+                                          const AntibodyParams& ab_params,
+                                          const StudyParams& study_params,
+                                          int n_steps, int burnin, int n_chains, int n_threads,
+                                          double* acceptance_rates, ProposalScales* proposal_scales,
+                                          Recorder&& record) {
+    int n_individuals = int(individuals.size());
+    int n_blocks = (n_individuals + kParallelBlockSize - 1) / kParallelBlockSize;
+    
+    parallelFor(n_chains * n_blocks, n_threads, [&](int task) {
+        int chain = task / n_blocks;
+        int block = task % n_blocks;
+        
+        int end = std::min(n_individuals, (block + 1) * kParallelBlockSize);
+        for (int i = block * kParallelBlockSize; i < end; i++) {
+            const IndividualView& individual = individuals[i];
+            RngStream initial_stream(seed, RngStream::InitialState, unsigned(i), unsigned(chain));
+            RngStream stream(seed, RngStream::MCMCStep, unsigned(i), unsigned(chain));
+            IndividualMCMC initial = dispersedInitialState(initial_stream, individual, ab_params, study_params);
+            size_t index = size_t(chain) * n_individuals + i;
+            proposal_scales[index] = ProposalScales::defaults(study_params);
+            acceptance_rates[index] = runChainIndividual(
+                stream, individual, initial, ab_params, study_params, n_steps, burnin,
+                proposal_scales[index],
+                [&](int step, const IndividualMCMC& state) { record(chain, i, step, state); });
+        }
+    });
+}
+
+// Pull-style iterator over a simulated study: each next() simulates the
+// following chunk_size individuals (in parallel) into a reused chunk. The
+// simulator must outlive the stream.
+class StudyStream {
+public:
+    StudyStream(SeroJumpSimulator& simulator_, const StudyParams& study_params_,
+                const AntibodyParams& ab_params_, int n_samples_per_individual_,
+                int chunk_size_, int n_threads_ = 1)
+        : simulator(simulator_), study_params(study_params_), ab_params(ab_params_),
+          n_samples_per_individual(n_samples_per_individual_),
+          chunk_size(std::max(1, chunk_size_)), n_threads(n_threads_) {}
+    
+    // The next chunk, or nullptr once the whole study has been produced
+    const Cohort* next() {
+        int count = std::min(chunk_size, study_params.n_individuals - produced);
+        if (count <= 0) return nullptr;
+        simulator.simulateChunk(study_params, ab_params, n_samples_per_individual,
+                                produced, count, chunk, n_threads);
+        produced += count;
+        return &chunk;
+    }
+    
+    int individualsProduced() const { return produced; }
+    int chunkSize() const { return chunk_size; }
+    int samplesPerIndividual() const { return n_samples_per_individual; }
+    
+private:
+    SeroJumpSimulator& simulator;
+    StudyParams study_params;
+    AntibodyParams ab_params;
+    int n_samples_per_individual;
+    int chunk_size;
+    int n_threads;
+    int produced = 0;
+    Cohort chunk;
+};
+
+// A cohort registered once through the C interface, together with its model
+// settings and one MCMC chain per individual, so stepping it needs nothing but
+// the handle. Current states, counters and the chain output of the last
+// step() live in flat arrays owned here, which JS reads in place as typed-array
+// views on the WASM heap (cohort_array). Individual i's step s draws from
+// (seed, i, step s) as in runChainsParallel's chain 0.
+class CohortHandle {
+public:
+    // Arrays exposed through array(); each is double unless noted
+    enum Array {
+        Baseline = 0,           // [individual]
+        Boost = 1,              // [individual]
+        InfectionTime = 2,      // [individual], earliest infection or -1
+        InfectionCount = 3,     // [individual], int
+        LogLikelihood = 4,      // [individual]
+        AcceptedCount = 5,      // [individual], int, accepted steps at or after burn-in
+        StepsRun = 6,           // [individual], int
+        ProposalScale = 7,      // [individual][3]: baseline, boost, infection-time step
+        AllInfectionTimes = 8,  // [individual][max_infections], -1 past the count
+        TraceBaseline = 9,      // [individual][last step() count]
+        TraceBoost = 10,
+        TraceInfectionTime = 11,
+        TraceInfectionCount = 12,  // int
+        TraceLogLikelihood = 13,
+        Population = 14,        // [kPopulationValues]: baseline mean, sd, boost mean, sd,
+                                // observation sd, infection rate
+        TracePopulation = 15,   // [last step() count][kPopulationValues], hierarchical only
+        kNumArrays = 16
+    };
+    static constexpr int kPopulationValues = 6;
+    
+    CohortHandle(SeroJumpSimulator& simulator_, Cohort cohort_);
+    
+    // Model settings; chains start (or keep their states, re-scored) from here
+    void setModel(const StudyParams& study_params, const AntibodyParams& ab_params, int burnin);
+    bool hasModel() const { return has_model; }
+    
+    // Also sample the population parameters (HyperPriors) after every sweep
+    // of step(), starting from and centred on setModel's values
+    void setHierarchical(bool enabled);
+    bool isHierarchical() const { return hierarchical; }
+    
+    // Replace the model's infection hazard, re-scoring the current states
+    void setInfectionHazard(const InfectionHazard& hazard);
+    const InfectionHazard& infectionHazard() const { return study_params.infection_hazard; }
+    
+    // Advance every chain n_steps on n_threads workers, tracing each step. In
+    // hierarchical mode every chain takes one step, then the population
+    // parameters are drawn, n_steps times.
+    void step(int n_steps, int n_threads);
+    
+    // Advance one chain n_steps without tracing
+    void stepIndividual(int i, int n_steps);
+    
+    // Start of an exposed array and its number of elements. Pointers change
+    // when the trace length changes and when the WASM heap grows.
+    void* array(Array which, int& length);
+    
+    int size() const { return cohort.size(); }
+    
+private:
+    // trace_column < 0 traces nothing; the chain's change to the population
+    // sums is added to delta
+    void advance(int i, int n_steps, int trace_column, PopulationSums& delta);
+    void publish(int i);
+    void publishPopulation();
+    
+    SeroJumpSimulator& simulator;
+    Cohort cohort;
+    std::vector<IndividualView> views;
+    StudyParams study_params{0.0, 1.0, 0, 0.0, {}};
+    AntibodyParams ab_params{};
+    int burnin = 0;
+    bool has_model = false;
+    int trace_length = 0;
+    bool hierarchical = false;
+    HyperPriors priors;
+    PopulationSums population;
+    int population_updates = 0;
+    
+    std::vector<IndividualMCMC> states;
+    std::vector<ProposalScales> scales;
+    std::vector<double> baselines, boosts, infection_times, log_likelihoods, proposal_scales, all_infection_times;
+    std::vector<int> infection_counts, accepted, steps_run;
+    std::vector<double> trace_baselines, trace_boosts, trace_infection_times, trace_log_likelihoods;
+    std::vector<int> trace_infection_counts;
+    std::vector<double> squared_residuals;  // [individual], behind each cached log-likelihood
+    std::vector<double> population_values, trace_population;
 };
 
+template <typename Consumer>
+bool SeroJumpSimulator::simulateStudyChunked(const StudyParams& study_params,
+                                             const AntibodyParams& ab_params,
+                                             int n_samples_per_individual, int chunk_size,
+                                             int n_threads, Consumer&& consume) {
+    StudyStream stream(*this, study_params, ab_params, n_samples_per_individual, chunk_size, n_threads);
+    while (const Cohort* chunk = stream.next()) {
+        if (!consume(*chunk)) return false;
+    }
+    return true;
+}
+
 // C interface for Emscripten
 extern "C" {
     // Simulator management
@@ -131,7 +793,58 @@ extern "C" {
                       double* true_infection_times, int* infection_status,
                       int* out_total_samples);
     
-    // Individual MCMC step
+    // The same study produced chunk_size individuals at a time: each
+    // study_stream_next fills buffers sized for one chunk (ids and samples
+    // flat, status and infection times per individual of the chunk) and
+    // returns how many individuals it wrote, 0 once the study is exhausted.
+    StudyStream* create_study_stream(SeroJumpSimulator* simulator,
+                                     double study_start, double study_end, int n_individuals,
+                                     double infection_rate, int n_samples_per_individual,
+                                     double baseline_mean, double baseline_sd,
+                                     double boost_mean, double boost_sd,
+                                     double decay_rate, double observation_sd,
+                                     int chunk_size);
+    int study_stream_next(StudyStream* stream,
+                          int* individual_ids, double* sample_times, double* titre_values,
+                          double* true_infection_times, int* infection_status,
+                          int* out_total_samples);
+    void destroy_study_stream(StudyStream* stream);
+    
+    // Persistent cohort handles. create_cohort_handle copies the cohort in once
+    // (NULL if sample times are not ascending); cohort_set_model sets the
+    // model (or changes it, re-scoring the current states; 0 if a rate, sd or
+    // decay is out of range, leaving the handle as it was), with gibbs
+    // non-zero for exact baseline / boost draws and time_grid > 0 for grid
+    // infection-time proposals (the hazard carries over from the last call),
+    // cohort_set_infection_hazard shapes infection times with n_intervals
+    // equal-width relative hazards over the window (0 = uniform), and
+    // cohort_set_hierarchical turns population-parameter sampling on or off;
+    // cohort_step advances every chain n_steps on n_threads threads (0 = all),
+    // tracing the steps, and cohort_step_individual advances one chain.
+    // cohort_array returns the start and length of one CohortHandle::Array;
+    // build typed arrays on the heap from it after each call rather than
+    // keeping them.
+    CohortHandle* create_cohort_handle(SeroJumpSimulator* simulator,
+                                       int n_individuals, int* individual_ids,
+                                       double* sample_times_all, double* titre_values_all,
+                                       int* n_samples_per_individual);
+    int cohort_set_model(CohortHandle* handle,
+                         double study_start, double study_end, double infection_rate,
+                         int max_infections,
+                         double baseline_mean, double baseline_sd, double boost_mean, double boost_sd,
+                         double decay_rate, double observation_sd, int burnin, int gibbs,
+                         int time_grid);
+    int cohort_set_infection_hazard(CohortHandle* handle, int n_intervals, double* hazard);
+    int cohort_set_hierarchical(CohortHandle* handle, int enabled);
+    int cohort_step(CohortHandle* handle, int n_steps, int n_threads);
+    int cohort_step_individual(CohortHandle* handle, int individual, int n_steps);
+    void* cohort_array(CohortHandle* handle, int array, int* out_length);
+    void destroy_cohort_handle(CohortHandle* handle);
+    
+    // Individual MCMC step. An uninfected state's boost is not in the
+    // likelihood but is in the prior, so a non-positive one (e.g. the 0 a
+    // fresh state starts with) is replaced by boost_mean, or boost_sd if that
+    // is not positive either.
     int mcmc_step_individual(SeroJumpSimulator* simulator,
                            // Individual data
                            int individual_id, double* sample_times, double* titre_values, int n_samples,
@@ -149,14 +862,17 @@ extern "C" {
                            int* new_infected_state, double* new_log_likelihood,
                            int* accepted, double* acceptance_rate);
     
-    // Run full MCMC for study
+    // Run full MCMC for study. In every chain output, infected_state holds the
+    // number of infections and infection_time the earliest one (-1 if none).
+    // Proposal steps are adapted during burn-in; proposal_scales (may be NULL)
+    // receives the adapted [baseline, boost, infection time] steps, [individual][3].
     int run_mcmc_study(SeroJumpSimulator* simulator,
                       // Study data
                       int n_individuals, int* individual_ids, 
                       double* sample_times_all, double* titre_values_all, 
                       int* n_samples_per_individual,
                       // MCMC settings
-                      int n_steps, int burnin,
+                      int n_steps, int burnin, int max_infections,
                       // Study parameters  
                       double study_start, double study_end, double infection_rate,
                       double baseline_mean, double baseline_sd, double boost_mean, double boost_sd,
@@ -164,7 +880,82 @@ extern "C" {
                       // Output (pre-allocated)
                       double* baseline_chains, double* boost_chains, double* infection_time_chains,
                       int* infected_state_chains, double* log_likelihood_chains,
-                      double* acceptance_rates);
+                      double* acceptance_rates, double* proposal_scales);
+    
+    // Run n_chains chains for the study on n_threads native threads (0 = all).
+    // Chain outputs are laid out [chain][individual][step]; acceptance_rates
+    // is [chain][individual] and proposal_scales (may be NULL) [chain][individual][3].
+    int run_mcmc_study_parallel(SeroJumpSimulator* simulator,
+                               int n_individuals, int* individual_ids,
+                               double* sample_times_all, double* titre_values_all,
+                               int* n_samples_per_individual,
+                               int n_steps, int burnin, int n_chains, int n_threads,
+                               int max_infections,
+                               double study_start, double study_end, double infection_rate,
+                               double baseline_mean, double baseline_sd, double boost_mean, double boost_sd,
+                               double decay_rate, double observation_sd,
+                               double* baseline_chains, double* boost_chains, double* infection_time_chains,
+                               int* infected_state_chains, double* log_likelihood_chains,
+                               double* acceptance_rates, double* proposal_scales);
+    
+    // Streaming MCMC: summaries instead of chains, so memory is O(n_individuals).
+    // Every thin-th post-burn-in draw is kept. Per-individual outputs: posterior
+    // means/sds (boost and infection time over infected draws only; NaN if never
+    // infected), infection probability, infection-time quantiles [individual][3]
+    // at 2.5%/50%/97.5%, infection-time histograms [individual][n_bins] over the
+    // study window, and the acceptance rate and adapted proposal steps
+    // (proposal_scales [individual][3], may be NULL) averaged over chains.
+    int run_mcmc_study_summary(SeroJumpSimulator* simulator,
+                              int n_individuals, int* individual_ids,
+                              double* sample_times_all, double* titre_values_all,
+                              int* n_samples_per_individual,
+                              int n_steps, int burnin, int thin, int n_chains, int n_threads,
+                              int max_infections,
+                              double study_start, double study_end, double infection_rate,
+                              double baseline_mean, double baseline_sd, double boost_mean, double boost_sd,
+                              double decay_rate, double observation_sd,
+                              int n_bins,
+                              double* baseline_means, double* baseline_sds,
+                              double* boost_means, double* boost_sds,
+                              double* infection_probs,
+                              double* infection_time_means, double* infection_time_sds,
+                              double* infection_time_quantiles,
+                              unsigned int* infection_time_histograms,
+                              double* acceptance_rates, double* proposal_scales);
+    
+    // Streaming MCMC that stops itself: as run_mcmc_study_summary, but the
+    // chains advance check_interval steps at a time (up to max_steps) and
+    // split-R-hat / ESS are updated at every pause after burn-in. With
+    // stop_when_converged the run ends once the baseline and infection count of
+    // every individual and the two study totals have R-hat <= max_rhat and
+    // ESS >= min_ess. Diagnostics outputs: per-individual R-hat/ESS (NaN if
+    // never checked), study_diagnostics[4] = total infections R-hat, ESS, total
+    // log-likelihood R-hat, ESS; laggards receives the n_laggards individuals
+    // still missing a threshold; steps_run and converged describe the stop.
+    int run_mcmc_study_until_converged(SeroJumpSimulator* simulator,
+                                       int n_individuals, int* individual_ids,
+                                       double* sample_times_all, double* titre_values_all,
+                                       int* n_samples_per_individual,
+                                       int max_steps, int burnin, int thin, int n_chains, int n_threads,
+                                       int max_infections,
+                                       int check_interval, double max_rhat, double min_ess,
+                                       int stop_when_converged,
+                                       double study_start, double study_end, double infection_rate,
+                                       double baseline_mean, double baseline_sd, double boost_mean, double boost_sd,
+                                       double decay_rate, double observation_sd,
+                                       int n_bins,
+                                       double* baseline_means, double* baseline_sds,
+                                       double* boost_means, double* boost_sds,
+                                       double* infection_probs,
+                                       double* infection_time_means, double* infection_time_sds,
+                                       double* infection_time_quantiles,
+                                       unsigned int* infection_time_histograms,
+                                       double* acceptance_rates, double* proposal_scales,
+                                       double* baseline_rhats, double* baseline_ess,
+                                       double* infection_rhats, double* infection_ess,
+                                       double* study_diagnostics,
+                                       int* laggards, int* n_laggards,
+                                       int* steps_run, int* converged);
     
     // Utility functions
     double compute_titre(double baseline, double boost, double decay_rate,
@@ -1,233 +1,1118 @@
 #include <iostream>
-#include <fstream>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <atomic>
+#include <vector>
+#include <unordered_map>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <chrono>
 #include <cstring>
-#include <map>
+#include <cstdlib>
+#include <cerrno>
+#include <csignal>
 
-#ifdef _WIN32
-    #include <winsock2.h>
-    #include <ws2tcpip.h>
-    #pragma comment(lib, "ws2_32.lib")
-#else
-    #include <sys/socket.h>
-    #include <netinet/in.h>
-    #include <unistd.h>
-    #include <arpa/inet.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#if defined(__linux__)
+    #include <sys/sendfile.h>
 #endif
 
+#include "async_log.hpp"
+#include "event_poller.hpp"
+#include "http_request.hpp"
+#include "static_cache.hpp"
+#include "compute_api.hpp"
+#include "metrics.hpp"
+
+// Command-line configurable settings:
+// serojump_server [--port N] [--backlog N] [--workers N] [--watch]
+//                 [--idle-timeout S] [--request-timeout S]
+//                 [--job-threads N] [--job-queue N] [--compute-threads N]
+//                 [--result-cache-mb N] [--result-cache-dir DIR] [--result-cache-disk-mb N]
+struct ServerConfig {
+    int port = 1010;
+    int backlog = SOMAXCONN;
+    int n_workers = 0;               // event-loop threads; 0 = one per hardware thread
+    std::string web_root = "web";
+    bool watch = false;              // reload the asset cache when web_root changes (Linux)
+    int idle_timeout_s = 30;         // close connections with no traffic for this long
+    int request_timeout_s = 10;      // a request (head and body) must arrive within this
+    int job_threads = 1;             // compute jobs run at once
+    int job_queue = 4;               // jobs waiting beyond that before requests get 503
+    int compute_threads = 0;         // compute threads per job; 0 = one per hardware thread
+    uint64_t max_body_bytes = 64ull << 20;  // largest /api/ request body
+    int result_cache_mb = 64;        // memory for cached /api/ results; 0 = none
+    std::string result_cache_dir;    // spill evicted results here; empty = no spill
+    int result_cache_disk_mb = 1024; // disk budget of the spill directory
+};
+
+// Static file server for the widget. A fixed pool of worker threads each runs
+// its own event loop over non-blocking sockets; all of them watch the shared
+// listening socket, and a connection stays on the worker that accepted it for
+// its whole (keep-alive) lifetime. POST /api/simulate and /api/fit run the
+// native sampler as queued jobs (see compute_api.hpp) whose events are
+// streamed back to the connection by its worker; their results are cached
+// (see result_cache.hpp) and GET /api/cache reports the hit/miss counters.
+// GET /metrics exposes request latency per path, traffic, connection, job,
+// cache and MCMC counters in Prometheus text format; per-request log lines go
+// through an AsyncLog so the workers never block on stdout.
 class SimpleHTTPServer {
 private:
-    int server_socket;
-    bool running;
-    const int PORT = 1010;
-    
-    std::map<std::string, std::string> mimeTypes = {
-        {".html", "text/html"},
-        {".js", "application/javascript"},
-        {".wasm", "application/wasm"},
-        {".css", "text/css"},
-        {".csv", "text/csv"},
-        {".png", "image/png"},
-        {".jpg", "image/jpeg"},
-        {".jpeg", "image/jpeg"},
-        {".gif", "image/gif"},
-        {".svg", "image/svg+xml"}
+    ServerConfig config;
+    StaticAssetCache assets;
+    std::unique_ptr<JobQueue> jobs;
+    std::unique_ptr<ResultCache> results;
+    ComputeLimits compute_limits;
+    AsyncLog request_log;
+    int server_socket = -1;
+    std::atomic<bool> running{false};
+    std::vector<std::thread> workers;
+
+    // Largest request head (request line + headers) we accept, and the
+    // per-connection receive buffer (room for a maximal head plus more)
+    static constexpr size_t kMaxRequestHead = 16 * 1024;
+    static constexpr size_t kInputBufferSize = kMaxRequestHead + 4 * 1024;
+    // Poll timeout, bounds how long stop() waits for the workers
+    static constexpr int kPollTimeoutMs = 500;
+
+    struct ServerMetrics {
+        metrics::HistogramFamily request_latency;   // by path
+        metrics::Counter bytes_sent;
+        metrics::Counter connections_accepted;
+        metrics::Gauge active_connections;
     };
-    
-    std::string getFileExtension(const std::string& filename) {
-        size_t dot = filename.find_last_of('.');
-        if (dot != std::string::npos) {
-            return filename.substr(dot);
-        }
-        return "";
-    }
-    
-    std::string getMimeType(const std::string& filename) {
-        std::string ext = getFileExtension(filename);
-        auto it = mimeTypes.find(ext);
-        if (it != mimeTypes.end()) {
-            return it->second;
-        }
-        return "text/plain";
-    }
-    
-    std::string readFile(const std::string& filename) {
-        std::ifstream file(filename, std::ios::binary);
-        if (!file.is_open()) {
-            return "";
-        }
-        
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        return buffer.str();
-    }
-    
-    void handleRequest(int client_socket) {
-        char buffer[1024] = {0};
-        ssize_t bytes_read = recv(client_socket, buffer, 1023, 0);
-        
-        if (bytes_read <= 0) {
-            return;
+    ServerMetrics server_metrics;
+
+    // A piece of queued response: owned bytes (headers, small bodies), bytes
+    // borrowed from a cached asset, or a range of a streamed asset's file.
+    // [begin, end) is what is still to be sent.
+    struct OutputSegment {
+        std::string text;
+        std::shared_ptr<const StaticAsset> asset;   // keeps borrowed bytes / descriptor alive
+        const char* bytes = nullptr;
+        int file_fd = -1;
+        uint64_t begin = 0;
+        uint64_t end = 0;
+        // Set on the last segment of a response: observed once it is written
+        metrics::Histogram* latency = nullptr;
+        int64_t request_started_ns = 0;
+
+        bool fromFile() const { return file_fd >= 0; }
+        const char* memory() const { return bytes ? bytes : text.data(); }
+    };
+
+    // What handleRequest produces: a head, and optionally part of an asset as the body
+    struct Response {
+        std::string route;       // latency label: the asset's path, or "not_found"
+        std::string head;
+        std::shared_ptr<const StaticAsset> asset;
+        StaticAsset::Encoding encoding = StaticAsset::Identity;
+        uint64_t begin = 0;
+        uint64_t end = 0;
+    };
+
+    // Per-connection state, owned by one worker. Received bytes live in a
+    // fixed buffer, allocated on first read and reused for every request;
+    // [input_begin, input_end) is what has not been consumed yet.
+    struct Connection {
+        std::unique_ptr<char[]> input;
+        size_t input_begin = 0;
+        size_t input_end = 0;
+        HttpRequestParser parser{kMaxRequestHead};
+        std::deque<OutputSegment> output;   // response pieces not yet sent, in order
+        uint64_t body_to_skip = 0;   // request body bytes still to discard
+        bool close_after_write = false;
+        bool want_read = true;       // poller currently watching for readability
+        bool want_write = false;     // poller currently watching for writability
+        int64_t last_activity_ms = 0;
+        int64_t request_started_ms = 0;     // first byte of a still-incomplete request; 0 if none
+        // An /api/ request whose body is being collected, then the job
+        // answering it; later pipelined requests wait until the job finishes
+        bool api_pending = false;
+        std::string api_target;
+        std::string api_body;
+        uint64_t api_body_remaining = 0;
+        bool api_keep_alive = true;
+        bool api_chunked = true;     // HTTP/1.0 clients get a close-delimited stream
+        int64_t api_started_ns = 0;
+        std::shared_ptr<JobChannel> job;
+    };
+
+    // Writev batch size and the per-call cap for sendfile
+    static constexpr int kMaxIovecs = 64;
+    static constexpr size_t kMaxSendfileChunk = 1 << 20;
+
+    static bool setNonBlocking(int fd) {
+        int flags = fcntl(fd, F_GETFL, 0);
+        return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+
+    // Parse a single "bytes=" range against a representation of length size.
+    // Returns 1 for a satisfiable range, 0 to ignore the header (malformed or
+    // multiple ranges: serve the whole thing), -1 for unsatisfiable (416).
+    static int parseRange(std::string_view header, uint64_t size, uint64_t& begin, uint64_t& end) {
+        const std::string_view prefix = "bytes=";
+        if (header.substr(0, prefix.size()) != prefix) return 0;
+        std::string_view spec = header.substr(prefix.size());
+        if (spec.find(',') != std::string_view::npos) return 0;
+        size_t dash = spec.find('-');
+        if (dash == std::string_view::npos) return 0;
+        std::string_view first = spec.substr(0, dash);
+        std::string_view last = spec.substr(dash + 1);
+        auto number = [](std::string_view text, uint64_t& value) {
+            if (text.empty() || text.size() > 18) return false;
+            value = 0;
+            for (char c : text) {
+                if (c < '0' || c > '9') return false;
+                value = value * 10 + uint64_t(c - '0');
+            }
+            return true;
+        };
+
+        uint64_t first_byte = 0;
+        uint64_t last_byte = 0;
+        if (first.empty()) {
+            // Suffix range: the final N bytes
+            if (!number(last, last_byte)) return 0;
+            if (last_byte == 0 || size == 0) return -1;
+            begin = size - std::min(last_byte, size);
+            end = size;
+            return 1;
+        }
+        if (!number(first, first_byte)) return 0;
+        if (last.empty()) {
+            last_byte = size - 1;
+        } else if (!number(last, last_byte) || last_byte < first_byte) {
+            return 0;
         }
-        
-        std::string request(buffer, bytes_read);
-        
-        // Parse the request
-        std::istringstream request_stream(request);
-        std::string method, path, version;
-        request_stream >> method >> path >> version;
-        
-        std::cout << "📡 " << method << " " << path << std::endl;
-        
+        if (first_byte >= size) return -1;
+        begin = first_byte;
+        end = std::min(last_byte, size - 1) + 1;
+        return 1;
+    }
+
+    // Build the response for one request, from the in-memory asset cache
+    Response handleRequest(const HttpRequest& request) {
+        request_log.printf("📡 %.*s %.*s", int(request.method.size()), request.method.data(),
+                           int(request.target.size()), request.target.data());
+        Response response;
+
+        std::string path(request.target.substr(0, request.target.find('?')));
+
         // Default to index.html
         if (path == "/" || path.empty()) {
             path = "/index.html";
         }
-        
-        // Security: prevent directory traversal
-        if (path.find("..") != std::string::npos) {
-            sendNotFound(client_socket);
-            return;
+
+        // Only files loaded from the web root are in the cache, so there is
+        // nothing outside it to traverse to
+        std::shared_ptr<const StaticAsset> asset = assets.find(path);
+        if (!asset) {
+            response.route = "not_found";
+            response.head = notFoundResponse(request.keep_alive);
+            return response;
         }
-        
-        // Construct file path (web directory)
-        std::string filepath = "web" + path;
-        
-        // Try to read the file
-        std::string content = readFile(filepath);
-        
-        if (content.empty()) {
-            sendNotFound(client_socket);
-            return;
+        response.route = path;
+
+        StaticAsset::Encoding encoding = StaticAssetCache::chooseEncoding(*asset, request.accept_encoding);
+        const std::string& etag = asset->etag[encoding];
+        if (!request.if_none_match.empty() && StaticAssetCache::matchesETag(request.if_none_match, etag)) {
+            response.head = notModifiedResponse(etag, request.keep_alive);
+            return response;
+        }
+
+        uint64_t size = asset->size(encoding);
+        uint64_t begin = 0;
+        uint64_t end = size;
+        int range = 0;
+        // Ranges apply to GET only, and If-Range (a strong ETag) must still match
+        if (request.method == "GET" && !request.range.empty() &&
+            (request.if_range.empty() || request.if_range == etag)) {
+            range = parseRange(request.range, size, begin, end);
+        }
+        if (range < 0) {
+            response.head = rangeNotSatisfiableResponse(etag, size, request.keep_alive);
+            return response;
         }
-        
-        // Send response
-        std::string mime_type = getMimeType(filepath);
-        sendResponse(client_socket, content, mime_type);
+
+        response.head = okHead(*asset, encoding, begin, end, range > 0, request.keep_alive);
+        if (request.method != "HEAD") {
+            response.asset = asset;
+            response.encoding = encoding;
+            response.begin = begin;
+            response.end = end;
+        }
+        return response;
+    }
+
+    static void writeCommonHeaders(std::ostream& response, const std::string& etag, bool keep_alive) {
+        response << "Connection: " << (keep_alive ? "keep-alive" : "close") << "\r\n";
+        response << "Access-Control-Allow-Origin: *\r\n";
+        // Revalidate every time; an unchanged file costs a 304 rather than a download
+        response << "Cache-Control: no-cache\r\n";
+        response << "ETag: " << etag << "\r\n";
+        response << "Vary: Accept-Encoding\r\n";
+        response << "Accept-Ranges: bytes\r\n";
+        // Cross-origin isolation, so a pthreads build of the module gets SharedArrayBuffer
+        response << "Cross-Origin-Opener-Policy: same-origin\r\n";
+        response << "Cross-Origin-Embedder-Policy: credentialless\r\n";
     }
-    
-    void sendResponse(int client_socket, const std::string& content, const std::string& mime_type) {
+
+    // Status line and headers for a 200, or a 206 covering [begin, end)
+    std::string okHead(const StaticAsset& asset, StaticAsset::Encoding encoding,
+                       uint64_t begin, uint64_t end, bool partial, bool keep_alive) {
         std::stringstream response;
-        response << "HTTP/1.1 200 OK\r\n";
-        response << "Content-Type: " << mime_type << "\r\n";
-        response << "Content-Length: " << content.length() << "\r\n";
+        response << (partial ? "HTTP/1.1 206 Partial Content\r\n" : "HTTP/1.1 200 OK\r\n");
+        response << "Content-Type: " << asset.mime_type << "\r\n";
+        response << "Content-Length: " << (end - begin) << "\r\n";
+        if (partial) {
+            response << "Content-Range: bytes " << begin << "-" << (end - 1) << "/" << asset.size(encoding) << "\r\n";
+        }
+        if (encoding != StaticAsset::Identity) {
+            response << "Content-Encoding: " << StaticAssetCache::encodingName(encoding) << "\r\n";
+        }
+        writeCommonHeaders(response, asset.etag[encoding], keep_alive);
+        response << "\r\n";
+        return response.str();
+    }
+
+    std::string notModifiedResponse(const std::string& etag, bool keep_alive) {
+        std::stringstream response;
+        response << "HTTP/1.1 304 Not Modified\r\n";
+        writeCommonHeaders(response, etag, keep_alive);
+        response << "\r\n";
+        return response.str();
+    }
+
+    std::string rangeNotSatisfiableResponse(const std::string& etag, uint64_t size, bool keep_alive) {
+        std::stringstream response;
+        response << "HTTP/1.1 416 Range Not Satisfiable\r\n";
+        response << "Content-Range: bytes */" << size << "\r\n";
+        response << "Content-Length: 0\r\n";
+        writeCommonHeaders(response, etag, keep_alive);
+        response << "\r\n";
+        return response.str();
+    }
+
+    std::string notFoundResponse(bool keep_alive) {
+        const std::string body = "<html><body><h1>404 Not Found</h1></body></html>";
+        return "HTTP/1.1 404 Not Found\r\n"
+               "Content-Type: text/html\r\n"
+               "Content-Length: " + std::to_string(body.size()) + "\r\n"
+               "Connection: " + (keep_alive ? "keep-alive" : "close") + "\r\n"
+               "\r\n" + body;
+    }
+
+    std::string errorResponse(const std::string& status) {
+        return "HTTP/1.1 " + status + "\r\n"
+               "Content-Length: 0\r\n"
+               "Connection: close\r\n"
+               "\r\n";
+    }
+
+    static std::string apiErrorResponse(const std::string& status, const std::string& message, bool keep_alive) {
+        std::string body = JsonWriter().beginObject().key("error").value(message).endObject().str();
+        std::stringstream response;
+        response << "HTTP/1.1 " << status << "\r\n";
+        response << "Content-Type: application/json\r\n";
+        response << "Content-Length: " << body.size() << "\r\n";
+        response << "Connection: " << (keep_alive ? "keep-alive" : "close") << "\r\n";
         response << "Access-Control-Allow-Origin: *\r\n";
+        if (status.compare(0, 3, "503") == 0) response << "Retry-After: 5\r\n";
+        response << "\r\n" << body;
+        return response.str();
+    }
+
+    static std::string eventStreamHead(bool keep_alive, bool chunked, const char* cache_status) {
+        std::stringstream response;
+        response << "HTTP/1.1 200 OK\r\n";
+        response << "Content-Type: text/event-stream\r\n";
         response << "Cache-Control: no-cache\r\n";
+        response << "X-Cache: " << cache_status << "\r\n";
+        if (chunked) response << "Transfer-Encoding: chunked\r\n";
+        response << "Connection: " << (keep_alive && chunked ? "keep-alive" : "close") << "\r\n";
+        response << "Access-Control-Allow-Origin: *\r\n";
         response << "\r\n";
-        response << content;
-        
-        std::string response_str = response.str();
-        send(client_socket, response_str.c_str(), response_str.length(), 0);
+        return response.str();
     }
-    
-    void sendNotFound(int client_socket) {
-        std::string response = "HTTP/1.1 404 Not Found\r\n"
-                             "Content-Type: text/html\r\n"
-                             "Content-Length: 47\r\n"
-                             "\r\n"
-                             "<html><body><h1>404 Not Found</h1></body></html>";
-        send(client_socket, response.c_str(), response.length(), 0);
+
+    static std::string chunk(const std::string& data) {
+        char size[20];
+        std::snprintf(size, sizeof(size), "%zx\r\n", data.size());
+        return size + data + "\r\n";
+    }
+
+    static bool isApiTarget(std::string_view target) {
+        return target.substr(0, 5) == "/api/";
+    }
+
+    std::string cacheStatsResponse(bool keep_alive) {
+        ResultCache::Stats stats = results->stats();
+        JsonWriter json;
+        json.beginObject();
+        json.key("hits").value(double(stats.hits));
+        json.key("disk_hits").value(double(stats.disk_hits));
+        json.key("misses").value(double(stats.misses));
+        json.key("evictions").value(double(stats.evictions));
+        json.key("spills").value(double(stats.spills));
+        json.key("entries").value(double(stats.entries));
+        json.key("bytes").value(double(stats.bytes));
+        json.key("disk_entries").value(double(stats.disk_entries));
+        json.key("disk_bytes").value(double(stats.disk_bytes));
+        json.endObject();
+        std::string body = json.str();
+        std::stringstream response;
+        response << "HTTP/1.1 200 OK\r\n";
+        response << "Content-Type: application/json\r\n";
+        response << "Content-Length: " << body.size() << "\r\n";
+        response << "Cache-Control: no-store\r\n";
+        response << "Connection: " << (keep_alive ? "keep-alive" : "close") << "\r\n";
+        response << "Access-Control-Allow-Origin: *\r\n";
+        response << "\r\n" << body;
+        return response.str();
+    }
+
+    std::string metricsResponse(bool keep_alive) {
+        using metrics::PrometheusText;
+        PrometheusText text;
+        text.family("serojump_http_request_duration_seconds", "histogram",
+                    "Time from a complete request head to the last byte of its response, by path");
+        server_metrics.request_latency.forEach([&](const std::string& path, const metrics::Histogram& histogram) {
+            text.histogram("serojump_http_request_duration_seconds", PrometheusText::label("path", path), histogram);
+        });
+        text.family("serojump_http_sent_bytes_total", "counter", "Bytes written to client sockets")
+            .sample("serojump_http_sent_bytes_total", "", double(server_metrics.bytes_sent.value()));
+        text.family("serojump_http_connections_accepted_total", "counter", "Client connections accepted")
+            .sample("serojump_http_connections_accepted_total", "", double(server_metrics.connections_accepted.value()));
+        text.family("serojump_http_active_connections", "gauge", "Client connections currently open")
+            .sample("serojump_http_active_connections", "", double(server_metrics.active_connections.value()));
+        text.family("serojump_log_dropped_lines_total", "counter", "Request log lines dropped because the log ring was full")
+            .sample("serojump_log_dropped_lines_total", "", double(request_log.dropped()));
+        text.family("serojump_jobs_waiting", "gauge", "Compute jobs queued and not yet started")
+            .sample("serojump_jobs_waiting", "", double(jobs->waitingJobs()));
+
+        ResultCache::Stats cache = results->stats();
+        text.family("serojump_result_cache_lookups_total", "counter", "Result cache lookups by outcome")
+            .sample("serojump_result_cache_lookups_total", "outcome=\"hit\"", double(cache.hits))
+            .sample("serojump_result_cache_lookups_total", "outcome=\"disk_hit\"", double(cache.disk_hits))
+            .sample("serojump_result_cache_lookups_total", "outcome=\"miss\"", double(cache.misses));
+        text.family("serojump_result_cache_evictions_total", "counter", "Results evicted from memory")
+            .sample("serojump_result_cache_evictions_total", "", double(cache.evictions));
+        text.family("serojump_result_cache_bytes", "gauge", "Bytes of cached results in memory")
+            .sample("serojump_result_cache_bytes", "", double(cache.bytes));
+
+        // Steps per second is rate(serojump_mcmc_proposals_total)
+        MCMCCounters& mcmc = mcmcCounters();
+        text.family("serojump_mcmc_proposals_total", "counter", "MCMC steps proposed, by move type");
+        for (int m = 0; m < MCMCCounters::kMoves; m++) {
+            text.sample("serojump_mcmc_proposals_total", PrometheusText::label("move", moveTypeName(MoveType(m))),
+                        double(mcmc.proposed[m].value()));
+        }
+        text.family("serojump_mcmc_accepted_total", "counter", "MCMC proposals accepted, by move type");
+        for (int m = 0; m < MCMCCounters::kMoves; m++) {
+            text.sample("serojump_mcmc_accepted_total", PrometheusText::label("move", moveTypeName(MoveType(m))),
+                        double(mcmc.accepted[m].value()));
+        }
+
+        const std::string& body = text.str();
+        std::stringstream response;
+        response << "HTTP/1.1 200 OK\r\n";
+        response << "Content-Type: " << PrometheusText::kContentType << "\r\n";
+        response << "Content-Length: " << body.size() << "\r\n";
+        response << "Cache-Control: no-store\r\n";
+        response << "Connection: " << (keep_alive ? "keep-alive" : "close") << "\r\n";
+        response << "\r\n" << body;
+        return response.str();
+    }
+
+    // Latency label of an /api/ path; unknown ones share one
+    static std::string_view apiRoute(std::string_view path) {
+        for (std::string_view known : { "/api/simulate", "/api/fit", "/api/cache" }) {
+            if (path == known) return known;
+        }
+        return "not_found";
+    }
+
+    // Queue text ending the current /api/ request's response
+    void answerApi(Connection& connection, std::string text) {
+        queueText(connection, std::move(text));
+        timeResponse(connection, apiRoute(connection.api_target), connection.api_started_ns);
+    }
+
+    // Head of an /api/ request has arrived: get ready to collect its body
+    void beginApiRequest(Connection& connection, const HttpRequest& request, int64_t started_ns) {
+        request_log.printf("📡 %.*s %.*s", int(request.method.size()), request.method.data(),
+                           int(request.target.size()), request.target.data());
+        connection.api_target.assign(request.target.substr(0, request.target.find('?')));
+        connection.api_started_ns = started_ns;
+        if (request.method == "GET" && connection.api_target == "/api/cache") {
+            answerApi(connection, cacheStatsResponse(request.keep_alive));
+            connection.body_to_skip = request.content_length;
+            if (!request.keep_alive) connection.close_after_write = true;
+            return;
+        }
+        if (request.method != "POST") {
+            answerApi(connection, apiErrorResponse("405 Method Not Allowed", "use POST", request.keep_alive));
+            connection.body_to_skip = request.content_length;
+            if (!request.keep_alive) connection.close_after_write = true;
+            return;
+        }
+        if (request.content_length > config.max_body_bytes) {
+            answerApi(connection, apiErrorResponse("413 Payload Too Large", "request body too large", false));
+            connection.close_after_write = true;
+            return;
+        }
+        connection.api_pending = true;
+        connection.api_body.clear();
+        connection.api_body.reserve(size_t(request.content_length));
+        connection.api_body_remaining = request.content_length;
+        connection.api_keep_alive = request.keep_alive;
+        connection.api_chunked = request.version == "HTTP/1.1";
+    }
+
+    // Body complete: validate it and queue the job, or answer with an error
+    void startApiRequest(Connection& connection, const std::shared_ptr<WakePipe>& wake) {
+        std::string body;
+        body.swap(connection.api_body);
+        bool keep_alive = connection.api_keep_alive;
+
+        FlatJson json;
+        std::string error;
+        if (!json.parse(body, error)) {
+            answerApi(connection, apiErrorResponse("400 Bad Request", error, keep_alive));
+            return;
+        }
+
+        auto channel = std::make_shared<JobChannel>(wake);
+        ResultCache* cache = results->enabled() ? results.get() : nullptr;
+        std::string key;
+        std::function<void()> job;
+        if (connection.api_target == "/api/simulate") {
+            SimulateRequest request;
+            if (parseSimulateRequest(json, compute_limits, request, error)) {
+                key = resultCacheKey(request);
+                job = [request, channel, cache, key]() { runSimulateJob(request, *channel, cache, key); };
+            }
+        } else if (connection.api_target == "/api/fit") {
+            auto request = std::make_shared<FitRequest>();
+            if (parseFitRequest(json, compute_limits, *request, error)) {
+                key = resultCacheKey(*request);
+                job = [request, channel, cache, key]() { runFitJob(*request, *channel, cache, key); };
+            }
+        } else {
+            answerApi(connection, apiErrorResponse("404 Not Found", "no such endpoint", keep_alive));
+            return;
+        }
+        if (!job) {
+            answerApi(connection, apiErrorResponse("400 Bad Request", error, keep_alive));
+            return;
+        }
+
+        // A result held in memory is answered right here, without a job
+        std::string cached;
+        if (cache && cache->get(key, cached)) {
+            request_log.printf("💾 %s served from the result cache", connection.api_target.c_str());
+            bool chunked = connection.api_chunked;
+            std::string event = sseEvent("result", cached);
+            queueText(connection, eventStreamHead(keep_alive, chunked, "HIT"));
+            answerApi(connection, chunked ? chunk(event) + "0\r\n\r\n" : event);
+            if (!keep_alive || !chunked) connection.close_after_write = true;
+            return;
+        }
+
+        size_t position = 0;
+        if (!jobs->submit(std::move(job), position)) {
+            answerApi(connection, apiErrorResponse("503 Service Unavailable", "job queue is full", keep_alive));
+            return;
+        }
+        request_log.printf("🧮 %s queued behind %zu job(s)", connection.api_target.c_str(), position);
+
+        queueText(connection, eventStreamHead(keep_alive, connection.api_chunked, cache ? "MISS" : "BYPASS"));
+        std::string queued = sseEvent("queued", JsonWriter().beginObject().key("position")
+                                                    .value(int(position)).endObject().str());
+        queueText(connection, connection.api_chunked ? chunk(queued) : queued);
+        connection.job = channel;
+    }
+
+    // Move a job's posted events onto the connection; once it has finished,
+    // end the stream and carry on with any pipelined requests
+    void deliverJobOutput(Connection& connection, int64_t now_ms, const std::shared_ptr<WakePipe>& wake) {
+        std::string events;
+        bool finished = connection.job->take(events);
+        if (!events.empty()) {
+            queueText(connection, connection.api_chunked ? chunk(events) : events);
+        }
+        if (!finished) return;
+        connection.job.reset();
+        if (connection.api_chunked) {
+            queueText(connection, "0\r\n\r\n");
+        }
+        timeResponse(connection, apiRoute(connection.api_target), connection.api_started_ns);
+        if (!connection.api_keep_alive || !connection.api_chunked) {
+            connection.close_after_write = true;
+        }
+        processInput(connection, now_ms, wake);
+    }
+
+    static void queueText(Connection& connection, std::string text) {
+        OutputSegment segment;
+        segment.end = text.size();
+        segment.text = std::move(text);
+        connection.output.push_back(std::move(segment));
+    }
+
+    // Headers are owned; the body is borrowed from the asset, not copied
+    static void queueResponse(Connection& connection, Response response) {
+        queueText(connection, std::move(response.head));
+        if (!response.asset || response.begin == response.end) return;
+        OutputSegment body;
+        body.begin = response.begin;
+        body.end = response.end;
+        if (response.asset->streamed(response.encoding)) {
+            body.file_fd = response.asset->file_fd;
+        } else {
+            body.bytes = response.asset->body[response.encoding].data();
+        }
+        body.asset = std::move(response.asset);
+        connection.output.push_back(std::move(body));
+    }
+
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Time the response just queued, from started_ns until its last byte is
+    // written (flushOutput observes it)
+    void timeResponse(Connection& connection, std::string_view route, int64_t started_ns) {
+        metrics::Histogram& histogram = server_metrics.request_latency.get(route);
+        if (connection.output.empty()) {
+            histogram.observe(nowNs() - started_ns);
+            return;
+        }
+        connection.output.back().latency = &histogram;
+        connection.output.back().request_started_ns = started_ns;
+    }
+
+    static const char* statusFor(HttpParseResult result) {
+        switch (result) {
+            case HttpParseResult::HeadTooLarge: return "431 Request Header Fields Too Large";
+            case HttpParseResult::NotImplemented: return "501 Not Implemented";
+            default: return "400 Bad Request";
+        }
+    }
+
+    // Consume every complete request in the input buffer, queueing responses in order
+    void processInput(Connection& connection, int64_t now_ms, const std::shared_ptr<WakePipe>& wake) {
+        while (!connection.close_after_write && !connection.job) {
+            size_t available = connection.input_end - connection.input_begin;
+            if (connection.body_to_skip > 0) {
+                size_t skipped = size_t(std::min<uint64_t>(connection.body_to_skip, available));
+                connection.input_begin += skipped;
+                connection.body_to_skip -= skipped;
+                available -= skipped;
+                if (connection.body_to_skip > 0) break;
+            }
+            if (connection.api_pending) {
+                size_t taken = size_t(std::min<uint64_t>(connection.api_body_remaining, available));
+                connection.api_body.append(connection.input.get() + connection.input_begin, taken);
+                connection.input_begin += taken;
+                connection.api_body_remaining -= taken;
+                if (connection.api_body_remaining > 0) break;
+                connection.api_pending = false;
+                startApiRequest(connection, wake);
+                continue;
+            }
+            if (available == 0) break;
+
+            HttpRequest request;
+            size_t head_size = 0;
+            HttpParseResult result = connection.parser.parse(connection.input.get() + connection.input_begin,
+                                                             available, request, head_size);
+            if (result == HttpParseResult::Incomplete) break;
+            int64_t started_ns = nowNs();
+            if (result != HttpParseResult::Complete) {
+                queueText(connection, errorResponse(statusFor(result)));
+                timeResponse(connection, "bad_request", started_ns);
+                connection.close_after_write = true;
+                break;
+            }
+
+            // The request's views point into the buffer, so answer before consuming it
+            connection.request_started_ms = 0;
+            if (isApiTarget(request.target)) {
+                beginApiRequest(connection, request, started_ns);
+                connection.input_begin += head_size;
+                connection.parser.reset();
+                continue;
+            }
+            if (request.target.substr(0, request.target.find('?')) == "/metrics") {
+                queueText(connection, metricsResponse(request.keep_alive));
+                timeResponse(connection, "/metrics", started_ns);
+            } else {
+                Response response = handleRequest(request);
+                std::string route = std::move(response.route);
+                queueResponse(connection, std::move(response));
+                timeResponse(connection, route, started_ns);
+            }
+            connection.input_begin += head_size;
+            connection.parser.reset();
+            connection.body_to_skip = request.content_length;
+            if (!request.keep_alive) connection.close_after_write = true;
+        }
+
+        if (connection.input_begin == connection.input_end) {
+            connection.input_begin = connection.input_end = 0;
+        }
+        // Unanswered bytes behind a running job are not a slow request
+        bool partial = !connection.job && (connection.input_end > connection.input_begin ||
+                                           connection.body_to_skip > 0 || connection.api_pending);
+        if (!partial) {
+            connection.request_started_ms = 0;
+        } else if (connection.request_started_ms == 0) {
+            connection.request_started_ms = now_ms;
+        }
+    }
+
+    // Send a streamed body range with sendfile (pread + send where there is none)
+    static ssize_t sendFromFile(int socket_fd, OutputSegment& segment) {
+        size_t count = size_t(std::min<uint64_t>(segment.end - segment.begin, kMaxSendfileChunk));
+#if defined(__linux__)
+        off_t offset = off_t(segment.begin);
+        return sendfile(socket_fd, segment.file_fd, &offset, count);
+#else
+        char buffer[64 * 1024];
+        ssize_t n = pread(segment.file_fd, buffer, std::min(count, sizeof(buffer)), off_t(segment.begin));
+        if (n <= 0) return n;
+        return send(socket_fd, buffer, size_t(n), 0);
+#endif
+    }
+
+    // Send as much queued output as the socket takes: runs of in-memory
+    // segments go out in one writev, file ranges through sendfile. Loops until
+    // the queue is empty or the socket would block. Returns false on error.
+    bool flushOutput(Connection& connection, int fd) {
+        while (!connection.output.empty()) {
+            OutputSegment& front = connection.output.front();
+            ssize_t sent;
+            if (front.fromFile()) {
+                sent = sendFromFile(fd, front);
+                // A streamed file that shrank under us: the response can't be completed
+                if (sent == 0) return false;
+            } else {
+                iovec iov[kMaxIovecs];
+                int n_iov = 0;
+                for (auto it = connection.output.begin();
+                     it != connection.output.end() && n_iov < kMaxIovecs && !it->fromFile(); ++it) {
+                    iov[n_iov].iov_base = const_cast<char*>(it->memory() + it->begin);
+                    iov[n_iov].iov_len = size_t(it->end - it->begin);
+                    n_iov++;
+                }
+                sent = writev(fd, iov, n_iov);
+            }
+
+            if (sent < 0) {
+                if (errno == EINTR) continue;
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+
+            // Retire what was written, possibly spanning several segments
+            server_metrics.bytes_sent.add(sent);
+            uint64_t remaining = uint64_t(sent);
+            while (remaining > 0) {
+                OutputSegment& segment = connection.output.front();
+                uint64_t taken = std::min(remaining, segment.end - segment.begin);
+                segment.begin += taken;
+                remaining -= taken;
+                if (segment.begin == segment.end) {
+                    if (segment.latency) segment.latency->observe(nowNs() - segment.request_started_ns);
+                    connection.output.pop_front();
+                }
+            }
+        }
+        return true;
+    }
+
+    void acceptConnections(EventPoller& poller, std::unordered_map<int, Connection>& connections, int64_t now_ms) {
+        while (true) {
+            int client_socket = accept(server_socket, nullptr, nullptr);
+            if (client_socket < 0) {
+                // EAGAIN: another worker took it or the queue is drained
+                if (errno == EINTR) continue;
+                return;
+            }
+            int one = 1;
+            setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            if (!setNonBlocking(client_socket) || !poller.add(client_socket, false)) {
+                close(client_socket);
+                continue;
+            }
+            connections[client_socket].last_activity_ms = now_ms;
+            server_metrics.connections_accepted.add();
+            server_metrics.active_connections.add(1);
+        }
+    }
+
+    void closeConnection(EventPoller& poller, std::unordered_map<int, Connection>& connections, int fd) {
+        auto it = connections.find(fd);
+        if (it != connections.end() && it->second.job) {
+            it->second.job->cancelled = true;
+        }
+        poller.remove(fd);
+        close(fd);
+        if (connections.erase(fd)) server_metrics.active_connections.add(-1);
+    }
+
+    // Read and answer one ready connection. Returns false on a socket error.
+    bool serviceConnection(Connection& connection, int fd, bool readable, int64_t now_ms,
+                           const std::shared_ptr<WakePipe>& wake) {
+        connection.last_activity_ms = now_ms;
+        if (readable) {
+            if (!connection.input) connection.input.reset(new char[kInputBufferSize]);
+            bool peer_closed = false;
+            while (!connection.close_after_write) {
+                if (connection.input_end == kInputBufferSize) {
+                    // Full: answer what is complete, then make room at the front
+                    processInput(connection, now_ms, wake);
+                    if (connection.input_begin == 0) break;
+                    std::memmove(connection.input.get(), connection.input.get() + connection.input_begin,
+                                 connection.input_end - connection.input_begin);
+                    connection.input_end -= connection.input_begin;
+                    connection.input_begin = 0;
+                    continue;
+                }
+                ssize_t received = recv(fd, connection.input.get() + connection.input_end,
+                                        kInputBufferSize - connection.input_end, 0);
+                if (received > 0) {
+                    connection.input_end += size_t(received);
+                } else if (received == 0) {
+                    peer_closed = true;
+                    break;
+                } else if (errno == EINTR) {
+                    continue;
+                } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    break;
+                } else {
+                    return false;
+                }
+            }
+            processInput(connection, now_ms, wake);
+            // Answer whatever complete requests arrived before the peer closed
+            if (peer_closed) connection.close_after_write = true;
+        }
+
+        return true;
+    }
+
+    static int64_t nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Close connections that have been idle too long, or that have spent too
+    // long sending one request (a slow or stalled client), so neither can pin
+    // a worker's resources. An unfinished request gets a 408 first.
+    void expireConnections(EventPoller& poller, std::unordered_map<int, Connection>& connections, int64_t now_ms) {
+        const int64_t idle_ms = int64_t(config.idle_timeout_s) * 1000;
+        const int64_t request_ms = int64_t(config.request_timeout_s) * 1000;
+        std::vector<int> expired;
+        for (auto& entry : connections) {
+            Connection& connection = entry.second;
+            // A connection waiting on its job is busy, not idle
+            if (connection.job) continue;
+            if (connection.output.empty() && connection.request_started_ms != 0 &&
+                now_ms - connection.request_started_ms > request_ms) {
+                queueText(connection, errorResponse("408 Request Timeout"));
+                flushOutput(connection, entry.first);
+                expired.push_back(entry.first);
+            } else if (now_ms - connection.last_activity_ms > idle_ms) {
+                expired.push_back(entry.first);
+            }
+        }
+        for (int fd : expired) {
+            closeConnection(poller, connections, fd);
+        }
+    }
+
+    // Flush a connection after it was serviced and watch for writability only
+    // while output is backed up. Reads stop once nothing more will be read
+    // (the poller is level triggered, so unread bytes would wake the worker
+    // over and over): after close_after_write, and while a job holds a full
+    // input buffer, resuming once the job has finished and the buffer has been
+    // consumed. Returns false once it should be closed.
+    bool settleConnection(EventPoller& poller, Connection& connection, int fd) {
+        if (!flushOutput(connection, fd)) return false;
+        if (connection.output.empty() && connection.close_after_write) return false;
+        bool want_read = !connection.close_after_write &&
+                         !(connection.job && connection.input_end == kInputBufferSize);
+        bool want_write = !connection.output.empty();
+        if (want_read != connection.want_read || want_write != connection.want_write) {
+            poller.modify(fd, want_read, want_write);
+            connection.want_read = want_read;
+            connection.want_write = want_write;
+        }
+        return true;
+    }
+
+    void workerLoop() {
+        EventPoller poller;
+        // Compute jobs wake this worker through the pipe when they post events
+        auto wake = std::make_shared<WakePipe>();
+        if (!poller.valid() || !wake->valid() || !poller.add(server_socket, false, true) ||
+            !poller.add(wake->readFd(), false)) {
+            std::cerr << "Failed to set up worker event loop" << std::endl;
+            return;
+        }
+
+        std::unordered_map<int, Connection> connections;
+        std::vector<EventPoller::Event> events;
+        std::vector<int> finished;
+        int64_t last_sweep_ms = nowMs();
+        while (running) {
+            poller.wait(events, kPollTimeoutMs);
+            int64_t now_ms = nowMs();
+            for (const EventPoller::Event& event : events) {
+                if (event.fd == server_socket) {
+                    acceptConnections(poller, connections, now_ms);
+                    continue;
+                }
+
+                if (event.fd == wake->readFd()) {
+                    wake->drain();
+                    finished.clear();
+                    for (auto& entry : connections) {
+                        Connection& connection = entry.second;
+                        if (!connection.job) continue;
+                        connection.last_activity_ms = now_ms;
+                        deliverJobOutput(connection, now_ms, wake);
+                        if (!settleConnection(poller, connection, entry.first)) finished.push_back(entry.first);
+                    }
+                    for (int fd : finished) {
+                        closeConnection(poller, connections, fd);
+                    }
+                    continue;
+                }
+
+                auto it = connections.find(event.fd);
+                if (it == connections.end()) continue;
+                Connection& connection = it->second;
+
+                bool keep = !event.hangup || event.readable;
+                keep = keep && serviceConnection(connection, event.fd, event.readable || event.hangup,
+                                                 now_ms, wake);
+                keep = keep && settleConnection(poller, connection, event.fd);
+                if (!keep) {
+                    closeConnection(poller, connections, event.fd);
+                }
+            }
+
+            if (now_ms - last_sweep_ms >= kPollTimeoutMs) {
+                expireConnections(poller, connections, now_ms);
+                last_sweep_ms = now_ms;
+            }
+        }
+
+        for (auto& entry : connections) {
+            if (entry.second.job) entry.second.job->cancelled = true;
+            close(entry.first);
+            server_metrics.active_connections.add(-1);
+        }
     }
 
 public:
+    explicit SimpleHTTPServer(const ServerConfig& config_) : config(config_), assets(config_.web_root) {}
+
     bool start() {
-        #ifdef _WIN32
-        WSADATA wsaData;
-        if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
-            std::cerr << "WSAStartup failed" << std::endl;
+        auto load_start = std::chrono::steady_clock::now();
+        int n_files = assets.load();
+        if (n_files < 0) {
+            std::cerr << "Failed to read web root ./" << config.web_root << "/" << std::endl;
             return false;
         }
-        #endif
-        
+        auto load_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - load_start).count();
+        if (config.watch && !assets.startWatching()) {
+            std::cerr << "⚠️  Could not watch ./" << config.web_root << "/ for changes" << std::endl;
+        }
+
         server_socket = socket(AF_INET, SOCK_STREAM, 0);
         if (server_socket < 0) {
             std::cerr << "Failed to create socket" << std::endl;
             return false;
         }
-        
+
         // Reuse address to avoid "Address already in use" error
         int opt = 1;
         setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, (char*)&opt, sizeof(opt));
-        
+
         sockaddr_in server_addr = {};
         server_addr.sin_family = AF_INET;
         server_addr.sin_addr.s_addr = INADDR_ANY;
-        server_addr.sin_port = htons(PORT);
-        
+        server_addr.sin_port = htons(config.port);
+
         if (bind(server_socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-            std::cerr << "Failed to bind to port " << PORT << std::endl;
+            std::cerr << "Failed to bind to port " << config.port << std::endl;
             return false;
         }
-        
-        if (listen(server_socket, 10) < 0) {
+
+        if (listen(server_socket, config.backlog) < 0 || !setNonBlocking(server_socket)) {
             std::cerr << "Failed to listen on socket" << std::endl;
             return false;
         }
-        
+
+        compute_limits.n_threads = config.compute_threads;
+        jobs.reset(new JobQueue(config.job_threads, size_t(config.job_queue)));
+        results.reset(new ResultCache(size_t(std::max(0, config.result_cache_mb)) << 20, config.result_cache_dir,
+                                      size_t(std::max(0, config.result_cache_disk_mb)) << 20));
         running = true;
-        
+
+        int n_workers = config.n_workers;
+        if (n_workers <= 0) {
+            n_workers = std::max(1u, std::thread::hardware_concurrency());
+        }
+        workers.reserve(n_workers);
+        for (int w = 0; w < n_workers; w++) {
+            workers.emplace_back(&SimpleHTTPServer::workerLoop, this);
+        }
+
         std::cout << "\n🧬 SeroJump WebAssembly Server" << std::endl;
-        std::cout << "🌐 Server running on http://localhost:" << PORT << std::endl;
-        std::cout << "📁 Serving files from ./web/ directory" << std::endl;
+        std::cout << "🌐 Server running on http://localhost:" << config.port << std::endl;
+        std::cout << "📁 Serving " << n_files << " files from ./" << config.web_root << "/ (cached and compressed in "
+                  << load_ms << " ms" << (config.watch ? ", reloading on change" : "") << ")" << std::endl;
+        std::cout << "🧵 " << n_workers << " event-loop workers, listen backlog " << config.backlog << std::endl;
+        std::cout << "🧮 Compute API at /api/simulate and /api/fit (" << config.job_threads
+                  << " running, " << config.job_queue << " queued)" << std::endl;
+        if (results->enabled()) {
+            std::cout << "💾 Result cache: " << config.result_cache_mb << " MB in memory";
+            if (!config.result_cache_dir.empty()) {
+                std::cout << ", spilling to " << config.result_cache_dir << "/ (" << config.result_cache_disk_mb
+                          << " MB)";
+            }
+            std::cout << std::endl;
+        }
+        std::cout << "📈 Prometheus metrics at /metrics" << std::endl;
         std::cout << "⚡ Ready for individual antibody trajectory analysis!" << std::endl;
         std::cout << "\nPress Ctrl+C to stop the server...\n" << std::endl;
-        
+
         return true;
     }
-    
+
+    // Async-signal-safe: the workers notice within one poll timeout
+    void requestStop() {
+        running = false;
+    }
+
+    // Block until the workers exit (after stop() or requestStop())
     void run() {
-        while (running) {
-            sockaddr_in client_addr = {};
-            socklen_t client_addr_len = sizeof(client_addr);
-            
-            int client_socket = accept(server_socket, (struct sockaddr*)&client_addr, &client_addr_len);
-            if (client_socket < 0) {
-                if (running) {
-                    std::cerr << "Failed to accept connection" << std::endl;
-                }
-                continue;
-            }
-            
-            // Handle request in a separate thread for concurrency
-            std::thread client_thread([this, client_socket]() {
-                this->handleRequest(client_socket);
-                #ifdef _WIN32
-                closesocket(client_socket);
-                #else
-                close(client_socket);
-                #endif
-            });
-            client_thread.detach();
+        for (auto& worker : workers) {
+            worker.join();
         }
+        workers.clear();
     }
-    
+
     void stop() {
         running = false;
-        #ifdef _WIN32
-        closesocket(server_socket);
-        WSACleanup();
-        #else
-        close(server_socket);
-        #endif
-    }
-    
+        assets.stopWatching();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+        // Workers cancelled their connections' jobs; wait for the running ones to notice
+        if (jobs) jobs->stop();
+        if (server_socket >= 0) {
+            close(server_socket);
+            server_socket = -1;
+        }
+    }
+
     ~SimpleHTTPServer() {
         stop();
     }
 };
 
-int main() {
-    SimpleHTTPServer server;
-    
+namespace {
+
+SimpleHTTPServer* running_server = nullptr;
+
+// Ctrl+C / SIGTERM shut down cleanly, so the result cache gets spilled
+void handleStopSignal(int) {
+    if (running_server) running_server->requestStop();
+}
+
+bool parseArguments(int argc, char** argv, ServerConfig& config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--port" && has_value) {
+            config.port = std::atoi(argv[++i]);
+        } else if (arg == "--backlog" && has_value) {
+            config.backlog = std::atoi(argv[++i]);
+        } else if (arg == "--workers" && has_value) {
+            config.n_workers = std::atoi(argv[++i]);
+        } else if (arg == "--watch") {
+            config.watch = true;
+        } else if (arg == "--idle-timeout" && has_value) {
+            config.idle_timeout_s = std::atoi(argv[++i]);
+        } else if (arg == "--request-timeout" && has_value) {
+            config.request_timeout_s = std::atoi(argv[++i]);
+        } else if (arg == "--job-threads" && has_value) {
+            config.job_threads = std::atoi(argv[++i]);
+        } else if (arg == "--job-queue" && has_value) {
+            config.job_queue = std::atoi(argv[++i]);
+        } else if (arg == "--compute-threads" && has_value) {
+            config.compute_threads = std::atoi(argv[++i]);
+        } else if (arg == "--result-cache-mb" && has_value) {
+            config.result_cache_mb = std::atoi(argv[++i]);
+        } else if (arg == "--result-cache-dir" && has_value) {
+            config.result_cache_dir = argv[++i];
+        } else if (arg == "--result-cache-disk-mb" && has_value) {
+            config.result_cache_disk_mb = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--port N] [--backlog N] [--workers N] [--watch]"
+                      << " [--idle-timeout S] [--request-timeout S]"
+                      << " [--job-threads N] [--job-queue N] [--compute-threads N]"
+                      << " [--result-cache-mb N] [--result-cache-dir DIR] [--result-cache-disk-mb N]" << std::endl;
+            return false;
+        }
+    }
+    return config.port > 0 && config.port < 65536 && config.backlog > 0 &&
+           config.idle_timeout_s > 0 && config.request_timeout_s > 0 &&
+           config.job_threads > 0 && config.job_queue >= 0 && config.compute_threads >= 0 &&
+           config.result_cache_mb >= 0 && config.result_cache_disk_mb >= 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    ServerConfig config;
+    if (!parseArguments(argc, argv, config)) {
+        return 1;
+    }
+
+    // Writes to a closed peer must fail with EPIPE rather than kill the process
+    std::signal(SIGPIPE, SIG_IGN);
+
+    SimpleHTTPServer server(config);
+
     if (!server.start()) {
         std::cerr << "❌ Failed to start server" << std::endl;
         return 1;
     }
-    
+
+    running_server = &server;
+    std::signal(SIGINT, handleStopSignal);
+    std::signal(SIGTERM, handleStopSignal);
     server.run();
-    
+    running_server = nullptr;
+    std::cout << "👋 Server stopped" << std::endl;
+
     return 0;
 }
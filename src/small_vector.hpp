@@ -0,0 +1,107 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+// Vector with inline storage for the first N elements; only grows onto the
+// heap beyond that. Used for per-individual infection times, where almost
+// every state holds at most a handful of entries and states are copied on
+// every MCMC proposal. Restricted to trivially copyable T.
+template <typename T, int N>
+class SmallVector {
+public:
+    SmallVector() = default;
+
+    SmallVector(const SmallVector& other) { assign(other.begin(), other.end()); }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) assign(other.begin(), other.end());
+        return *this;
+    }
+
+    SmallVector(SmallVector&& other) noexcept { moveFrom(other); }
+
+    SmallVector& operator=(SmallVector&& other) noexcept {
+        if (this != &other) {
+            heap_.reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    int size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    int capacity() const { return capacity_; }
+
+    T* data() { return heap_ ? heap_.get() : inline_; }
+    const T* data() const { return heap_ ? heap_.get() : inline_; }
+    T* begin() { return data(); }
+    T* end() { return data() + size_; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size_; }
+
+    T& operator[](int i) { return data()[i]; }
+    const T& operator[](int i) const { return data()[i]; }
+    T& front() { return data()[0]; }
+    const T& front() const { return data()[0]; }
+
+    void clear() { size_ = 0; }
+
+    void push_back(const T& value) {
+        reserve(size_ + 1);
+        data()[size_++] = value;
+    }
+
+    // Insert keeping the contents in ascending order
+    void insertSorted(const T& value) {
+        reserve(size_ + 1);
+        T* first = data();
+        T* position = std::upper_bound(first, first + size_, value);
+        std::copy_backward(position, first + size_, first + size_ + 1);
+        *position = value;
+        size_++;
+    }
+
+    void erase(int index) {
+        T* first = data();
+        std::copy(first + index + 1, first + size_, first + index);
+        size_--;
+    }
+
+    void reserve(int capacity) {
+        if (capacity <= capacity_) return;
+        int new_capacity = std::max(capacity, 2 * capacity_);
+        std::unique_ptr<T[]> grown(new T[new_capacity]);
+        std::copy(begin(), end(), grown.get());
+        heap_ = std::move(grown);
+        capacity_ = new_capacity;
+    }
+
+    template <typename Iterator>
+    void assign(Iterator first, Iterator last) {
+        int count = int(std::distance(first, last));
+        size_ = 0;
+        reserve(count);
+        std::copy(first, last, data());
+        size_ = count;
+    }
+
+private:
+    void moveFrom(SmallVector& other) {
+        size_ = other.size_;
+        if (other.heap_) {
+            heap_ = std::move(other.heap_);
+            capacity_ = other.capacity_;
+        } else {
+            capacity_ = N;
+            std::copy(other.inline_, other.inline_ + other.size_, inline_);
+        }
+        other.size_ = 0;
+        other.capacity_ = N;
+    }
+
+    T inline_[N];
+    std::unique_ptr<T[]> heap_;
+    int size_ = 0;
+    int capacity_ = N;
+};
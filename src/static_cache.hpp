@@ -0,0 +1,373 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "http_request.hpp"
+
+#if defined(SEROJUMP_HAVE_ZLIB)
+    #include <zlib.h>
+#endif
+#if defined(SEROJUMP_HAVE_BROTLI)
+    #include <brotli/encode.h>
+#endif
+#if defined(__linux__)
+    #include <sys/inotify.h>
+    #include <poll.h>
+#endif
+
+// In-memory copy of the web root. Every file is read once, its compressed
+// variants are built up front, and the whole set is published as an immutable
+// snapshot; a reload builds a new snapshot and swaps it in, so requests never
+// see a half-updated cache. Assets are shared_ptrs, so a response can keep
+// the bytes it is sending alive across a reload.
+//
+// Files larger than the stream threshold keep an open descriptor instead of
+// their identity bytes, and are sent with sendfile; their (much smaller)
+// compressed variants stay in memory.
+struct StaticAsset {
+    enum Encoding { Identity = 0, Gzip = 1, Brotli = 2, kEncodings = 3 };
+
+    std::string mime_type;
+    std::string body[kEncodings];     // empty when that encoding is unavailable or not smaller
+    std::string etag[kEncodings];     // strong, quoted; one per representation
+    std::filesystem::file_time_type modified;
+    int file_fd = -1;                 // identity body for streamed files, read with pread/sendfile
+    uint64_t file_size = 0;
+
+    StaticAsset() = default;
+    StaticAsset(const StaticAsset&) = delete;
+    StaticAsset& operator=(const StaticAsset&) = delete;
+    ~StaticAsset() {
+        if (file_fd >= 0) close(file_fd);
+    }
+
+    bool has(Encoding encoding) const { return encoding == Identity || !body[encoding].empty(); }
+    bool streamed(Encoding encoding) const { return encoding == Identity && file_fd >= 0; }
+    uint64_t size(Encoding encoding) const { return streamed(encoding) ? file_size : body[encoding].size(); }
+};
+
+class StaticAssetCache {
+public:
+    typedef std::unordered_map<std::string, std::shared_ptr<const StaticAsset>> Snapshot;
+
+    // Files above this size are streamed from disk rather than held in memory
+    static constexpr uint64_t kDefaultStreamThreshold = 256 * 1024;
+
+    explicit StaticAssetCache(std::string root_, uint64_t stream_threshold_ = kDefaultStreamThreshold)
+        : root(std::move(root_)), stream_threshold(stream_threshold_) {}
+
+    ~StaticAssetCache() { stopWatching(); }
+
+    // (Re)load every regular file under the root; files whose size and
+    // modification time are unchanged keep their existing asset. Returns the
+    // number of files, or -1 if the root cannot be read.
+    int load() {
+        std::lock_guard<std::mutex> lock(load_mutex);
+        std::shared_ptr<const Snapshot> previous = snapshot();
+        auto next = std::make_shared<Snapshot>();
+
+        std::error_code error;
+        std::filesystem::recursive_directory_iterator it(root, error), end;
+        if (error) return -1;
+        for (; it != end; it.increment(error)) {
+            if (error) break;
+            if (!it->is_regular_file(error)) continue;
+            std::string url = "/" + std::filesystem::relative(it->path(), root, error).generic_string();
+            auto modified = it->last_write_time(error);
+            uintmax_t size = it->file_size(error);
+
+            if (previous) {
+                auto old = previous->find(url);
+                if (old != previous->end() && old->second->modified == modified &&
+                    old->second->size(StaticAsset::Identity) == size) {
+                    (*next)[url] = old->second;
+                    continue;
+                }
+            }
+            std::shared_ptr<const StaticAsset> asset = buildAsset(it->path().string(), modified, stream_threshold);
+            if (asset) (*next)[url] = asset;
+        }
+
+        std::atomic_store(&current, std::shared_ptr<const Snapshot>(std::move(next)));
+        return int(snapshot()->size());
+    }
+
+    std::shared_ptr<const Snapshot> snapshot() const { return std::atomic_load(&current); }
+
+    std::shared_ptr<const StaticAsset> find(const std::string& url) const {
+        std::shared_ptr<const Snapshot> assets = snapshot();
+        if (!assets) return nullptr;
+        auto it = assets->find(url);
+        return it == assets->end() ? nullptr : it->second;
+    }
+
+    // Best representation for an Accept-Encoding header: brotli, then gzip,
+    // then identity, skipping codings the client refuses with q=0
+    static StaticAsset::Encoding chooseEncoding(const StaticAsset& asset, std::string_view accept_encoding) {
+        if (asset.has(StaticAsset::Brotli) && accepts(accept_encoding, "br")) return StaticAsset::Brotli;
+        if (asset.has(StaticAsset::Gzip) && accepts(accept_encoding, "gzip")) return StaticAsset::Gzip;
+        return StaticAsset::Identity;
+    }
+
+    // If-None-Match against a representation's ETag (weak comparison, as RFC 9110 requires)
+    static bool matchesETag(std::string_view if_none_match, std::string_view etag) {
+        while (!if_none_match.empty()) {
+            std::string_view tag = nextListItem(if_none_match);
+            if (tag == "*") return true;
+            if (tag.substr(0, 2) == "W/") tag.remove_prefix(2);
+            if (tag == etag) return true;
+        }
+        return false;
+    }
+
+    static const char* encodingName(StaticAsset::Encoding encoding) {
+        return encoding == StaticAsset::Brotli ? "br" : encoding == StaticAsset::Gzip ? "gzip" : "identity";
+    }
+
+    // Reload when anything under the root changes (Linux inotify; a no-op
+    // returning false elsewhere), including in directories created later.
+    // Bursts of events are coalesced.
+    bool startWatching() {
+#if defined(__linux__)
+        watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (watch_fd < 0) return false;
+        if (!watchTree(root)) return false;
+        watching = true;
+        watcher = std::thread([this]() { watchLoop(); });
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void stopWatching() {
+        watching = false;
+        if (watcher.joinable()) watcher.join();
+#if defined(__linux__)
+        if (watch_fd >= 0) {
+            close(watch_fd);
+            watch_fd = -1;
+        }
+#endif
+    }
+
+private:
+    // Pop the next comma-separated element, trimmed
+    static std::string_view nextListItem(std::string_view& list) {
+        size_t comma = list.find(',');
+        std::string_view item = list.substr(0, comma);
+        list.remove_prefix(comma == std::string_view::npos ? list.size() : comma + 1);
+        return HttpRequestParser::trim(item);
+    }
+
+    static bool accepts(std::string_view accept_encoding, std::string_view coding) {
+        while (!accept_encoding.empty()) {
+            std::string_view entry = nextListItem(accept_encoding);
+            size_t semicolon = entry.find(';');
+            std::string_view name = HttpRequestParser::trim(entry.substr(0, semicolon));
+            if (!HttpRequestParser::equalsIgnoreCase(name, coding) && name != "*") continue;
+            if (semicolon == std::string_view::npos) return true;
+            // Anything but q=0 (q=0, q=0.0, q=0.000) accepts
+            size_t q = entry.find("q=", semicolon);
+            if (q == std::string_view::npos) return true;
+            std::string_view weight = HttpRequestParser::trim(entry.substr(q + 2));
+            return weight.empty() || weight.find_first_not_of("0.") != std::string_view::npos;
+        }
+        return false;
+    }
+
+    static bool compressible(const std::string& mime_type) {
+        return mime_type.compare(0, 5, "text/") == 0 || mime_type == "application/javascript" ||
+               mime_type == "application/wasm" || mime_type == "application/json" ||
+               mime_type == "image/svg+xml";
+    }
+
+    static std::string mimeTypeFor(const std::string& path) {
+        static const std::map<std::string, std::string> mime_types = {
+            {".html", "text/html"},
+            {".js", "application/javascript"},
+            {".wasm", "application/wasm"},
+            {".css", "text/css"},
+            {".csv", "text/csv"},
+            {".json", "application/json"},
+            {".png", "image/png"},
+            {".jpg", "image/jpeg"},
+            {".jpeg", "image/jpeg"},
+            {".gif", "image/gif"},
+            {".svg", "image/svg+xml"}
+        };
+        size_t dot = path.find_last_of('.');
+        if (dot != std::string::npos) {
+            auto it = mime_types.find(path.substr(dot));
+            if (it != mime_types.end()) return it->second;
+        }
+        return "text/plain";
+    }
+
+    // 64-bit FNV-1a of the content, hex encoded, plus the length
+    static std::string contentTag(const std::string& content) {
+        uint64_t hash = 1469598103934665603ULL;
+        for (unsigned char c : content) {
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+        char tag[48];
+        std::snprintf(tag, sizeof(tag), "%016llx-%zx", (unsigned long long)hash, content.size());
+        return tag;
+    }
+
+    static std::shared_ptr<const StaticAsset> buildAsset(const std::string& path,
+                                                         std::filesystem::file_time_type modified,
+                                                         uint64_t stream_threshold) {
+        // Read through the descriptor a streamed asset keeps, so the tag
+        // always describes the bytes sendfile will send
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return nullptr;
+        auto asset = std::make_shared<StaticAsset>();
+        asset->file_fd = fd;
+        std::string& content = asset->body[StaticAsset::Identity];
+        char buffer[64 * 1024];
+        for (off_t offset = 0;;) {
+            ssize_t n = pread(fd, buffer, sizeof(buffer), offset);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) return nullptr;
+            if (n == 0) break;
+            content.append(buffer, size_t(n));
+            offset += n;
+        }
+        asset->mime_type = mimeTypeFor(path);
+        asset->modified = modified;
+
+        const std::string& identity = asset->body[StaticAsset::Identity];
+        if (compressible(asset->mime_type) && !identity.empty()) {
+            asset->body[StaticAsset::Gzip] = gzipCompress(identity);
+            asset->body[StaticAsset::Brotli] = brotliCompress(identity);
+            // Only keep variants that actually save bytes
+            for (int e = StaticAsset::Gzip; e < StaticAsset::kEncodings; e++) {
+                if (asset->body[e].size() >= identity.size()) asset->body[e].clear();
+            }
+        }
+
+        // Each representation has its own bytes, so its own strong tag
+        std::string tag = contentTag(identity);
+        asset->etag[StaticAsset::Identity] = "\"" + tag + "\"";
+        asset->etag[StaticAsset::Gzip] = "\"" + tag + "-gz\"";
+        asset->etag[StaticAsset::Brotli] = "\"" + tag + "-br\"";
+
+        // Large files keep the descriptor and drop the bytes; small ones the reverse
+        if (identity.size() > stream_threshold) {
+            asset->file_size = identity.size();
+            std::string().swap(asset->body[StaticAsset::Identity]);
+        } else {
+            close(asset->file_fd);
+            asset->file_fd = -1;
+        }
+        return asset;
+    }
+
+    static std::string gzipCompress(const std::string& input) {
+#if defined(SEROJUMP_HAVE_ZLIB)
+        z_stream stream = {};
+        // windowBits 15 + 16 selects the gzip wrapper
+        if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return "";
+        }
+        std::string output(deflateBound(&stream, input.size()), '\0');
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+        stream.avail_in = uInt(input.size());
+        stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+        stream.avail_out = uInt(output.size());
+        int status = deflate(&stream, Z_FINISH);
+        output.resize(stream.total_out);
+        deflateEnd(&stream);
+        return status == Z_STREAM_END ? output : "";
+#else
+        (void)input;
+        return "";
+#endif
+    }
+
+    static std::string brotliCompress(const std::string& input) {
+#if defined(SEROJUMP_HAVE_BROTLI)
+        size_t size = BrotliEncoderMaxCompressedSize(input.size());
+        if (size == 0) return "";
+        std::string output(size, '\0');
+        if (!BrotliEncoderCompress(BROTLI_MAX_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_GENERIC,
+                                   input.size(), reinterpret_cast<const uint8_t*>(input.data()),
+                                   &size, reinterpret_cast<uint8_t*>(&output[0]))) {
+            return "";
+        }
+        output.resize(size);
+        return output;
+#else
+        (void)input;
+        return "";
+#endif
+    }
+
+#if defined(__linux__)
+    // Watch a directory and every directory below it; wd -> path is kept so
+    // directories created under it later can be watched too
+    bool watchTree(const std::string& directory) {
+        const uint32_t mask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+        int wd = inotify_add_watch(watch_fd, directory.c_str(), mask);
+        if (wd < 0) return false;
+        watched_directories[wd] = directory;
+        std::error_code error;
+        for (std::filesystem::recursive_directory_iterator it(directory, error), end; !error && it != end;
+             it.increment(error)) {
+            if (!it->is_directory(error)) continue;
+            wd = inotify_add_watch(watch_fd, it->path().c_str(), mask);
+            if (wd >= 0) watched_directories[wd] = it->path().string();
+        }
+        return true;
+    }
+
+    void watchLoop() {
+        alignas(inotify_event) char buffer[4096];
+        while (watching) {
+            pollfd fd = { watch_fd, POLLIN, 0 };
+            if (poll(&fd, 1, 250) <= 0) continue;
+            // Drain the burst (an editor save is several events), then reload once
+            do {
+                ssize_t length;
+                while ((length = read(watch_fd, buffer, sizeof(buffer))) > 0) {
+                    for (ssize_t offset = 0; offset < length;) {
+                        const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                        offset += ssize_t(sizeof(inotify_event) + event->len);
+                        if (!(event->mask & IN_ISDIR) || !(event->mask & (IN_CREATE | IN_MOVED_TO))) continue;
+                        auto parent = watched_directories.find(event->wd);
+                        if (parent != watched_directories.end() && event->len > 0) {
+                            watchTree(parent->second + "/" + event->name);
+                        }
+                    }
+                }
+            } while (poll(&fd, 1, 100) > 0);
+            int n_files = load();
+            std::printf("🔄 Reloaded %d files from ./%s/\n", n_files, root.c_str());
+            std::fflush(stdout);
+        }
+    }
+
+    int watch_fd = -1;
+    std::unordered_map<int, std::string> watched_directories;   // watcher thread only after start
+#endif
+
+    std::string root;
+    uint64_t stream_threshold;
+    std::shared_ptr<const Snapshot> current;
+    std::mutex load_mutex;
+    std::atomic<bool> watching{false};
+    std::thread watcher;
+};
@@ -0,0 +1,363 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+// Vectorised titre / likelihood kernel.
+//
+// Builds with AVX2 (4 lanes) or SSE2 (2 lanes) natively and with WASM SIMD128
+// (2 lanes) under Emscripten when -msimd128 is set; otherwise falls back to a
+// scalar loop. The pre/post-infection branch in computeTitre becomes a lane
+// mask, and exp() is a Cody-Waite reduced polynomial accurate to a few ulp.
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define SEROJUMP_SIMD_AVX2 1
+#elif defined(__wasm_simd128__)
+    #include <wasm_simd128.h>
+    #define SEROJUMP_SIMD_WASM 1
+#elif defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define SEROJUMP_SIMD_SSE2 1
+#endif
+
+namespace titre_kernel {
+
+// Per-call constants of the Gaussian observation model, hoisted out of the sample loop
+struct LikelihoodConstants {
+    double log_norm;      // -0.5 * log(2*pi*sd^2), added once per sample
+    double inv_two_var;   // 1 / (2*sd^2)
+
+    explicit LikelihoodConstants(double observation_sd) {
+        double variance = observation_sd * observation_sd;
+        log_norm = -0.5 * std::log(2.0 * M_PI * variance);
+        inv_two_var = 0.5 / variance;
+    }
+
+    double logLikelihood(double sum_squared_residuals, int n_samples) const {
+        return n_samples * log_norm - inv_two_var * sum_squared_residuals;
+    }
+
+    // Inverse of logLikelihood: the sum of squared residuals behind a score
+    double sumSquaredResiduals(double log_likelihood, int n_samples) const {
+        return std::max(0.0, (n_samples * log_norm - log_likelihood) / inv_two_var);
+    }
+};
+
+#if defined(SEROJUMP_SIMD_AVX2)
+
+typedef __m256d vdouble;
+typedef __m256i vint64;
+constexpr int kLanes = 4;
+
+inline vdouble vset(double x) { return _mm256_set1_pd(x); }
+inline vdouble vload(const double* p) { return _mm256_loadu_pd(p); }
+inline void vstore(double* p, vdouble a) { _mm256_storeu_pd(p, a); }
+inline vdouble vadd(vdouble a, vdouble b) { return _mm256_add_pd(a, b); }
+inline vdouble vsub(vdouble a, vdouble b) { return _mm256_sub_pd(a, b); }
+inline vdouble vmul(vdouble a, vdouble b) { return _mm256_mul_pd(a, b); }
+inline vdouble vmax(vdouble a, vdouble b) { return _mm256_max_pd(a, b); }
+inline vdouble vmin(vdouble a, vdouble b) { return _mm256_min_pd(a, b); }
+// x where a > b, 0 elsewhere
+inline vdouble vselectGreater(vdouble a, vdouble b, vdouble x) {
+    return _mm256_and_pd(_mm256_cmp_pd(a, b, _CMP_GT_OQ), x);
+}
+inline vint64 vbits(vdouble a) { return _mm256_castpd_si256(a); }
+inline vdouble vfromBits(vint64 a) { return _mm256_castsi256_pd(a); }
+inline vint64 vsub64(vint64 a, vint64 b) { return _mm256_sub_epi64(a, b); }
+inline vint64 vadd64(vint64 a, vint64 b) { return _mm256_add_epi64(a, b); }
+inline vint64 vshiftExponent(vint64 a) { return _mm256_slli_epi64(a, 52); }
+inline double vsum(vdouble a) {
+    __m128d lo = _mm256_castpd256_pd128(a);
+    __m128d hi = _mm256_extractf128_pd(a, 1);
+    lo = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+#elif defined(SEROJUMP_SIMD_WASM)
+
+typedef v128_t vdouble;
+typedef v128_t vint64;
+constexpr int kLanes = 2;
+
+inline vdouble vset(double x) { return wasm_f64x2_splat(x); }
+inline vdouble vload(const double* p) { return wasm_v128_load(p); }
+inline void vstore(double* p, vdouble a) { wasm_v128_store(p, a); }
+inline vdouble vadd(vdouble a, vdouble b) { return wasm_f64x2_add(a, b); }
+inline vdouble vsub(vdouble a, vdouble b) { return wasm_f64x2_sub(a, b); }
+inline vdouble vmul(vdouble a, vdouble b) { return wasm_f64x2_mul(a, b); }
+inline vdouble vmax(vdouble a, vdouble b) { return wasm_f64x2_pmax(a, b); }
+inline vdouble vmin(vdouble a, vdouble b) { return wasm_f64x2_pmin(a, b); }
+inline vdouble vselectGreater(vdouble a, vdouble b, vdouble x) {
+    return wasm_v128_and(wasm_f64x2_gt(a, b), x);
+}
+inline vint64 vbits(vdouble a) { return a; }
+inline vdouble vfromBits(vint64 a) { return a; }
+inline vint64 vsub64(vint64 a, vint64 b) { return wasm_i64x2_sub(a, b); }
+inline vint64 vadd64(vint64 a, vint64 b) { return wasm_i64x2_add(a, b); }
+inline vint64 vshiftExponent(vint64 a) { return wasm_i64x2_shl(a, 52); }
+inline double vsum(vdouble a) {
+    return wasm_f64x2_extract_lane(a, 0) + wasm_f64x2_extract_lane(a, 1);
+}
+
+#elif defined(SEROJUMP_SIMD_SSE2)
+
+typedef __m128d vdouble;
+typedef __m128i vint64;
+constexpr int kLanes = 2;
+
+inline vdouble vset(double x) { return _mm_set1_pd(x); }
+inline vdouble vload(const double* p) { return _mm_loadu_pd(p); }
+inline void vstore(double* p, vdouble a) { _mm_storeu_pd(p, a); }
+inline vdouble vadd(vdouble a, vdouble b) { return _mm_add_pd(a, b); }
+inline vdouble vsub(vdouble a, vdouble b) { return _mm_sub_pd(a, b); }
+inline vdouble vmul(vdouble a, vdouble b) { return _mm_mul_pd(a, b); }
+inline vdouble vmax(vdouble a, vdouble b) { return _mm_max_pd(a, b); }
+inline vdouble vmin(vdouble a, vdouble b) { return _mm_min_pd(a, b); }
+inline vdouble vselectGreater(vdouble a, vdouble b, vdouble x) {
+    return _mm_and_pd(_mm_cmpgt_pd(a, b), x);
+}
+inline vint64 vbits(vdouble a) { return _mm_castpd_si128(a); }
+inline vdouble vfromBits(vint64 a) { return _mm_castsi128_pd(a); }
+inline vint64 vsub64(vint64 a, vint64 b) { return _mm_sub_epi64(a, b); }
+inline vint64 vadd64(vint64 a, vint64 b) { return _mm_add_epi64(a, b); }
+inline vint64 vshiftExponent(vint64 a) { return _mm_slli_epi64(a, 52); }
+inline double vsum(vdouble a) {
+    return _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a)));
+}
+
+#endif
+
+#if defined(SEROJUMP_SIMD_AVX2) || defined(SEROJUMP_SIMD_WASM) || defined(SEROJUMP_SIMD_SSE2)
+#define SEROJUMP_SIMD 1
+
+// exp(x) for every lane. x = n*ln2 + r with |r| <= ln2/2, exp(r) from a
+// degree-12 Taylor polynomial, 2^n built directly in the exponent bits.
+inline vdouble vexp(vdouble x) {
+    // Round-to-nearest trick: adding 1.5*2^52 leaves n in the low mantissa bits
+    const vdouble magic = vset(6755399441055744.0);
+
+    x = vmin(vmax(x, vset(-708.0)), vset(709.0));
+    vdouble shifted = vadd(vmul(x, vset(1.4426950408889634)), magic);
+    vdouble n = vsub(shifted, magic);
+    vdouble r = vsub(vsub(x, vmul(n, vset(0.693145751953125))),
+                     vmul(n, vset(1.42860682030941723212e-6)));
+
+    vdouble p = vset(1.0 / 479001600.0);
+    p = vadd(vmul(p, r), vset(1.0 / 39916800.0));
+    p = vadd(vmul(p, r), vset(1.0 / 3628800.0));
+    p = vadd(vmul(p, r), vset(1.0 / 362880.0));
+    p = vadd(vmul(p, r), vset(1.0 / 40320.0));
+    p = vadd(vmul(p, r), vset(1.0 / 5040.0));
+    p = vadd(vmul(p, r), vset(1.0 / 720.0));
+    p = vadd(vmul(p, r), vset(1.0 / 120.0));
+    p = vadd(vmul(p, r), vset(1.0 / 24.0));
+    p = vadd(vmul(p, r), vset(1.0 / 6.0));
+    p = vadd(vmul(p, r), vset(0.5));
+    p = vadd(vmul(p, r), vset(1.0));
+    p = vadd(vmul(p, r), vset(1.0));
+
+    vint64 exponent = vsub64(vbits(shifted), vbits(magic));
+    vint64 scale = vadd64(vshiftExponent(exponent), vbits(vset(1.0)));
+    return vmul(p, vfromBits(scale));
+}
+#endif
+
+// Sum of squared residuals over samples [first, n) for the titre model
+//   baseline + boost * sum_k exp(-decay_rate * (t - t_k))  over infections t_k < t
+// with n_infections infection times (none for an uninfected individual).
+inline double sumSquaredResiduals(const double* sample_times, const double* titre_values,
+                                  int first, int n, double baseline, double boost,
+                                  double decay_rate, const double* infection_times,
+                                  int n_infections) {
+    int i = first;
+    double ssr = 0.0;
+
+#if defined(SEROJUMP_SIMD)
+    vdouble acc = vset(0.0);
+    vdouble vbaseline = vset(baseline);
+
+    if (n_infections > 0) {
+        vdouble vboost = vset(boost);
+        vdouble vneg_decay = vset(-decay_rate);
+        vdouble zero = vset(0.0);
+        for (; i + kLanes <= n; i += kLanes) {
+            vdouble times = vload(sample_times + i);
+            vdouble waning = zero;
+            for (int k = 0; k < n_infections; k++) {
+                vdouble dt = vsub(times, vset(infection_times[k]));
+                vdouble decayed = vexp(vmul(vneg_decay, vmax(dt, zero)));
+                waning = vadd(waning, vselectGreater(dt, zero, decayed));
+            }
+            vdouble predicted = vadd(vbaseline, vmul(vboost, waning));
+            vdouble residual = vsub(vload(titre_values + i), predicted);
+            acc = vadd(acc, vmul(residual, residual));
+        }
+    } else {
+        for (; i + kLanes <= n; i += kLanes) {
+            vdouble residual = vsub(vload(titre_values + i), vbaseline);
+            acc = vadd(acc, vmul(residual, residual));
+        }
+    }
+    ssr = vsum(acc);
+#endif
+
+    for (; i < n; i++) {
+        double predicted = baseline;
+        for (int k = 0; k < n_infections; k++) {
+            if (sample_times[i] > infection_times[k]) {
+                predicted += boost * std::exp(-decay_rate * (sample_times[i] - infection_times[k]));
+            }
+        }
+        double residual = titre_values[i] - predicted;
+        ssr += residual * residual;
+    }
+
+    return ssr;
+}
+
+// Sufficient statistics of the titre model in (baseline, boost): with the
+// waning weight w = sum_k exp(-decay_rate * (t - t_k)) over infections t_k < t,
+// the residual of sample (t, y) is y - baseline - boost * w, so the sum of
+// squared residuals for any baseline and boost follows from these sums.
+struct LinearStats {
+    int n = 0;
+    double sum_y = 0.0, sum_yy = 0.0;
+    double sum_w = 0.0, sum_ww = 0.0, sum_wy = 0.0;
+
+    double sumSquaredResiduals(double baseline, double boost) const {
+        double ssr = sum_yy - 2.0 * baseline * sum_y - 2.0 * boost * sum_wy
+                   + n * baseline * baseline + 2.0 * baseline * boost * sum_w
+                   + boost * boost * sum_ww;
+        return ssr > 0.0 ? ssr : 0.0;
+    }
+};
+
+inline LinearStats linearStats(const double* sample_times, const double* titre_values, int n,
+                               double decay_rate, const double* infection_times, int n_infections) {
+    LinearStats stats;
+    stats.n = n;
+    int i = 0;
+
+#if defined(SEROJUMP_SIMD)
+    vdouble zero = vset(0.0);
+    vdouble vneg_decay = vset(-decay_rate);
+    vdouble y_acc = zero, yy_acc = zero, w_acc = zero, ww_acc = zero, wy_acc = zero;
+    for (; i + kLanes <= n; i += kLanes) {
+        vdouble times = vload(sample_times + i);
+        vdouble y = vload(titre_values + i);
+        vdouble waning = zero;
+        for (int k = 0; k < n_infections; k++) {
+            vdouble dt = vsub(times, vset(infection_times[k]));
+            vdouble decayed = vexp(vmul(vneg_decay, vmax(dt, zero)));
+            waning = vadd(waning, vselectGreater(dt, zero, decayed));
+        }
+        y_acc = vadd(y_acc, y);
+        yy_acc = vadd(yy_acc, vmul(y, y));
+        w_acc = vadd(w_acc, waning);
+        ww_acc = vadd(ww_acc, vmul(waning, waning));
+        wy_acc = vadd(wy_acc, vmul(waning, y));
+    }
+    stats.sum_y = vsum(y_acc);
+    stats.sum_yy = vsum(yy_acc);
+    stats.sum_w = vsum(w_acc);
+    stats.sum_ww = vsum(ww_acc);
+    stats.sum_wy = vsum(wy_acc);
+#endif
+
+    for (; i < n; i++) {
+        double y = titre_values[i];
+        double waning = 0.0;
+        for (int k = 0; k < n_infections; k++) {
+            if (sample_times[i] > infection_times[k]) {
+                waning += std::exp(-decay_rate * (sample_times[i] - infection_times[k]));
+            }
+        }
+        stats.sum_y += y;
+        stats.sum_yy += y * y;
+        stats.sum_w += waning;
+        stats.sum_ww += waning * waning;
+        stats.sum_wy += waning * y;
+    }
+
+    return stats;
+}
+
+// Residual y - prediction of every sample, for the titre model with the given
+// infection times (used with one infection left out by gridSquaredResiduals)
+inline void residuals(const double* sample_times, const double* titre_values, int n,
+                      double baseline, double boost, double decay_rate,
+                      const double* infection_times, int n_infections, double* out) {
+    int i = 0;
+
+#if defined(SEROJUMP_SIMD)
+    vdouble zero = vset(0.0);
+    vdouble vneg_decay = vset(-decay_rate);
+    vdouble vbaseline = vset(baseline);
+    vdouble vboost = vset(boost);
+    for (; i + kLanes <= n; i += kLanes) {
+        vdouble times = vload(sample_times + i);
+        vdouble waning = zero;
+        for (int k = 0; k < n_infections; k++) {
+            vdouble dt = vsub(times, vset(infection_times[k]));
+            vdouble decayed = vexp(vmul(vneg_decay, vmax(dt, zero)));
+            waning = vadd(waning, vselectGreater(dt, zero, decayed));
+        }
+        vstore(out + i, vsub(vload(titre_values + i), vadd(vbaseline, vmul(vboost, waning))));
+    }
+#endif
+
+    for (; i < n; i++) {
+        double waning = 0.0;
+        for (int k = 0; k < n_infections; k++) {
+            if (sample_times[i] > infection_times[k]) {
+                waning += std::exp(-decay_rate * (sample_times[i] - infection_times[k]));
+            }
+        }
+        out[i] = titre_values[i] - (baseline + boost * waning);
+    }
+}
+
+// out[i] = exp(x[i] - shift), e.g. normalised weights from log-weights
+inline void expShifted(const double* x, double shift, int n, double* out) {
+    int i = 0;
+
+#if defined(SEROJUMP_SIMD)
+    vdouble vshift = vset(shift);
+    for (; i + kLanes <= n; i += kLanes) {
+        vstore(out + i, vexp(vsub(vload(x + i), vshift)));
+    }
+#endif
+
+    for (; i < n; i++) out[i] = std::exp(x[i] - shift);
+}
+
+// Sum of squared residuals with one more infection at each grid time
+// t_g = first + g * spacing (g < n_grid), given the residuals without it: the
+// infection takes boost * exp(-decay_rate * (t - t_g)) off every later sample.
+// The grid is walked backwards with suffix sums over the ascending samples,
+// rescaled by exp(-decay_rate * spacing) per grid step, so the cost is
+// O(n + n_grid) and no exponent is positive.
+inline void gridSquaredResiduals(const double* sample_times, const double* residuals, int n,
+                                 double boost, double decay_rate,
+                                 double first, double spacing, int n_grid, double* out) {
+    double total = 0.0;
+    for (int i = 0; i < n; i++) total += residuals[i] * residuals[i];
+    
+    double step = std::exp(-decay_rate * spacing);
+    double cross = 0.0;     // sum of residual * exp(-decay_rate * (t - t_g)) over samples after t_g
+    double weight = 0.0;    // sum of exp(-2 * decay_rate * (t - t_g)) over the same samples
+    int next = n;           // samples [next, n) are after t_g
+    for (int g = n_grid - 1; g >= 0; g--) {
+        double grid_time = first + g * spacing;
+        cross *= step;
+        weight *= step * step;
+        while (next > 0 && sample_times[next - 1] > grid_time) {
+            next--;
+            double decayed = std::exp(-decay_rate * (sample_times[next] - grid_time));
+            cross += residuals[next] * decayed;
+            weight += decayed * decayed;
+        }
+        out[g] = std::max(0.0, total - 2.0 * boost * cross + boost * boost * weight);
+    }
+}
+
+} // namespace titre_kernel
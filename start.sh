@@ -39,7 +39,7 @@ echo -e "${GREEN}🚀 Starting SeroJump server...${NC}"
 echo ""
 
 # Start the server
-./build/serojump_server
+./build/serojump_server "$@"
 
 # The server will handle the rest
 
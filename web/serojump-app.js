@@ -582,7 +582,11 @@ class SeroJumpApp {
         const burninSteps = parseInt(document.getElementById('burnin-steps').value);
         
         try {
-            await this.runMCMCFitting(mcmcSteps, burninSteps);
+            if (this.canUseMCMCWorker()) {
+                await this.runMCMCFittingInWorker(mcmcSteps, burninSteps);
+            } else {
+                await this.runMCMCFitting(mcmcSteps, burninSteps);
+            }
         } catch (error) {
             this.showError(`MCMC fitting failed: ${error.message}`);
         } finally {
@@ -711,6 +715,171 @@ class SeroJumpApp {
         Plotly.newPlot(plotDiv, traces, layout, config);
     }
     
+    canUseMCMCWorker() {
+        // The worker needs the compiled module; the development mock runs on the main thread
+        return typeof Worker !== 'undefined' && this.module && !this.module.isMock;
+    }
+    
+    runMCMCFittingInWorker(mcmcSteps, burninSteps) {
+        const params = this.getSimulationParameters();
+        
+        if (!this.currentData || !Array.isArray(this.currentData)) {
+            return Promise.reject(new Error('No simulation data available. Please generate data first.'));
+        }
+        
+        // Flatten the cohort once; the worker copies it into WASM memory a single time
+        const individuals = this.currentData;
+        const nIndividuals = individuals.length;
+        const nSamples = Int32Array.from(individuals, ind => ind.sampleTimes.length);
+        const totalSamples = nSamples.reduce((a, b) => a + b, 0);
+        const cohort = {
+            ids: Int32Array.from(individuals, ind => ind.id),
+            nSamples,
+            sampleTimes: new Float64Array(totalSamples),
+            titreValues: new Float64Array(totalSamples)
+        };
+        let offset = 0;
+        for (const individual of individuals) {
+            cohort.sampleTimes.set(individual.sampleTimes, offset);
+            cohort.titreValues.set(individual.titreValues, offset);
+            offset += individual.sampleTimes.length;
+        }
+        
+        const trueInfections = individuals.filter(ind => ind.trueInfectionStatus).length;
+        const thinningInterval = 10;
+        const maxPlotPoints = 1000;
+        const maxInfections = 4;
+        const infectedSteps = new Float64Array(nIndividuals);
+        const infectionCounts = [];
+        const individualInfectionProbs = {};
+        const timingPosteriorSamples = {};
+        const posteriorSamples = { baseline: [], boost: [], infectionTimes: [] };
+        for (const individual of individuals) {
+            individualInfectionProbs[individual.id] = [];
+            timingPosteriorSamples[individual.id] = [];
+        }
+        
+        const startTime = Date.now();
+        let proposalScales = null;
+        
+        return new Promise((resolve, reject) => {
+            const worker = new Worker('serojump_worker.js');
+            this.mcmcWorker = worker;
+            
+            const finish = (error) => {
+                worker.terminate();
+                this.mcmcWorker = null;
+                error ? reject(error) : resolve();
+            };
+            
+            worker.onerror = (event) => finish(new Error(event.message));
+            worker.onmessage = (event) => {
+                const message = event.data;
+                
+                if (message.type === 'error') {
+                    finish(new Error(message.message));
+                    return;
+                }
+                
+                if (message.type === 'done') {
+                    this.updateMCMCProgress(mcmcSteps, mcmcSteps);
+                    this.updateSummaryStatistics(infectionCounts, individualInfectionProbs, trueInfections);
+                    this.updatePosteriorAnalysis(posteriorSamples, timingPosteriorSamples);
+                    console.log(`⚡ Worker MCMC finished in ${(message.elapsedMs / 1000).toFixed(2)}s`);
+                    if (proposalScales) {
+                        // Mean adapted [baseline, boost, infection time] steps
+                        const means = [0, 1, 2].map(k =>
+                            proposalScales.filter((_, index) => index % 3 === k)
+                                .reduce((a, b) => a + b, 0) / nIndividuals);
+                        console.log(`🎯 Adapted proposal steps: ${means.map(m => m.toFixed(3)).join(', ')}`);
+                    }
+                    finish();
+                    return;
+                }
+                
+                if (message.type !== 'chunk') return;
+                
+                // Chunk arrays are [individual][step] for steps firstStep .. firstStep + nSteps
+                const { firstStep, nSteps } = message;
+                proposalScales = message.proposalScales;
+                for (let s = 0; s < nSteps; s++) {
+                    const step = firstStep + s;
+                    if (step < burninSteps) continue;
+                    const keep = (step - burninSteps) % thinningInterval === 0;
+                    let totalInfected = 0;
+                    
+                    for (let i = 0; i < nIndividuals; i++) {
+                        const index = i * nSteps + s;
+                        // infectedState is the number of infections in this state
+                        const infected = message.infectedState[index] > 0 ? 1 : 0;
+                        totalInfected += infected;
+                        infectedSteps[i] += infected;
+                        
+                        if (keep) {
+                            const id = individuals[i].id;
+                            individualInfectionProbs[id].push(infected);
+                            posteriorSamples.baseline.push(message.baseline[index]);
+                            posteriorSamples.boost.push(message.boost[index]);
+                            if (infected) {
+                                timingPosteriorSamples[id].push(message.infectionTime[index]);
+                                posteriorSamples.infectionTimes.push(message.infectionTime[index]);
+                            }
+                        }
+                    }
+                    if (keep) infectionCounts.push(totalInfected);
+                }
+                
+                // Individual cards show the latest state with the running posterior probability
+                const completed = firstStep + nSteps;
+                const keptSteps = Math.max(0, completed - burninSteps);
+                for (let i = 0; i < nIndividuals; i++) {
+                    const last = i * nSteps + nSteps - 1;
+                    const firstTime = i * maxInfections;
+                    const result = {
+                        baseline: message.baseline[last],
+                        boost: message.boost[last],
+                        infectionTimes: Array.from(message.stateInfectionTimes.subarray(
+                            firstTime, firstTime + message.stateInfectionCounts[i])),
+                        logLikelihood: message.logLikelihood[last],
+                        infectionProbability: keptSteps > 0 ? infectedSteps[i] / keptSteps : 0.0
+                    };
+                    this.mcmcResults[individuals[i].id] = result;
+                    if (keptSteps > 0) {
+                        this.updateIndividualCard(individuals[i], result);
+                    }
+                }
+                
+                const totalAccepted = message.acceptedCounts.reduce((a, b) => a + b, 0);
+                const elapsed = (Date.now() - startTime) / 1000;
+                const remaining = elapsed / completed * (mcmcSteps - completed);
+                this.updateMCMCProgress(completed, mcmcSteps, keptSteps * nIndividuals, totalAccepted, remaining);
+                this.plotTotalInfections(infectionCounts.slice(-maxPlotPoints), trueInfections);
+            };
+            
+            // Permanent boosts (decay 0) match the JavaScript sampler's titre model
+            worker.postMessage({
+                type: 'run',
+                seed: Date.now(),
+                cohort,
+                params: {
+                    studyStart: 0,
+                    studyEnd: params.studyDuration,
+                    infectionRate: params.infectionRate,
+                    baselineMean: params.baselineMean,
+                    baselineSD: params.baselineSD,
+                    boostMean: params.antibodyBoost,
+                    boostSD: params.boostSD,
+                    decayRate: 0.0,
+                    observationSD: params.observationSD
+                },
+                nSteps: mcmcSteps,
+                burnin: burninSteps,
+                chunkSize: 250,
+                maxInfections
+            }, [cohort.ids.buffer, cohort.nSamples.buffer, cohort.sampleTimes.buffer, cohort.titreValues.buffer]);
+        });
+    }
+    
     async runMCMCFitting(mcmcSteps, burninSteps) {
         const params = this.getSimulationParameters();
         // Use fewer chains for better performance with large step counts
@@ -8,6 +8,8 @@ function createSeroJumpModule() {
         // Simulate loading delay
         setTimeout(() => {
             const mockModule = {
+                isMock: true,
+                
                 // Mock memory management
                 _malloc: (size) => {
                     return new ArrayBuffer(size);
@@ -105,6 +107,6 @@ function mockMCMCStep(args) {
     return 1;
 }
 
-// Export for global access
-window.createSeroJumpModule = createSeroJumpModule;
+// Export for global access (self is the window on pages and the global scope in workers)
+self.createSeroJumpModule = createSeroJumpModule;
 
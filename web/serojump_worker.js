@@ -0,0 +1,172 @@
+// SeroJump MCMC Web Worker
+// Runs the MCMC sweep off the main thread. The cohort is registered once as a
+// cohort handle, which keeps the model and chain state in WASM memory; each
+// chunk is one cohort_step call, whose output is sliced out of views on the
+// handle's arrays and posted back as transferable ArrayBuffers.
+//
+// Messages in:
+//   { type: 'run', seed, cohort: { ids, sampleTimes, titreValues, nSamples },
+//     params: { studyStart, studyEnd, infectionRate, baselineMean, baselineSD,
+//               boostMean, boostSD, decayRate, observationSD },
+//     nSteps, burnin, chunkSize, maxInfections, gibbs, hierarchical, timeGrid,
+//     infectionHazard }
+//   gibbs (optional) draws baseline and boost exactly instead of random-walking them
+//   timeGrid (optional) proposes infection times from a grid of that many cells
+//   infectionHazard (optional) is a relative infection hazard on equal-width
+//   intervals of the study window, shaping when infections happen (uniform if
+//   absent); values must be non-negative with a positive sum
+//   hierarchical (optional) also samples the population parameters every
+//   step, starting from params
+// Messages out:
+//   { type: 'ready' }
+//   { type: 'chunk', firstStep, nSteps, baseline, boost, infectionTime,
+//     infectedState, logLikelihood, acceptedCounts,
+//     stateInfectionTimes, stateInfectionCounts, proposalScales, population }
+//   Chain arrays are [individual][step]; infectedState holds the number of
+//   infections and infectionTime the earliest one. stateInfectionTimes is the
+//   chain state after the chunk, [individual][maxInfections], with
+//   stateInfectionCounts entries in use per individual. proposalScales is
+//   [individual][3] (baseline, boost, infection-time step), adapted during
+//   burn-in and fixed afterwards. population (hierarchical runs only) is
+//   [step][6]: baseline mean, baseline SD, boost mean, boost SD, observation
+//   SD, infection rate.
+//   { type: 'done', elapsedMs }
+//   { type: 'error', message }
+//
+// To cancel a run, terminate the worker; it never yields between chunks.
+
+importScripts('serojump_module.js');
+
+const modulePromise = createSeroJumpModule();
+
+function allocate(Module, heap, values, length) {
+    const bytesPerElement = heap.BYTES_PER_ELEMENT;
+    const ptr = Module._malloc(length * bytesPerElement);
+    if (values) {
+        heap.set(values, ptr / bytesPerElement);
+    }
+    return ptr;
+}
+
+// Copy of one of the handle's arrays (see CohortHandle::Array); the view is
+// made after each call because memory growth replaces the heap buffer
+function sliceArray(Module, handle, array, heapName) {
+    const lengthPtr = Module._malloc(4);
+    try {
+        const ptr = Module.ccall('cohort_array', 'number', ['number', 'number', 'number'],
+            [handle, array, lengthPtr]);
+        const length = Module.HEAP32[lengthPtr / 4];
+        const heap = Module[heapName];
+        const start = ptr / heap.BYTES_PER_ELEMENT;
+        return heap.slice(start, start + length);
+    } finally {
+        Module._free(lengthPtr);
+    }
+}
+
+// CohortHandle::Array
+const ARRAY = {
+    infectionCount: 3, acceptedCount: 5, proposalScale: 7, allInfectionTimes: 8,
+    traceBaseline: 9, traceBoost: 10, traceInfectionTime: 11, traceInfectionCount: 12,
+    traceLogLikelihood: 13, tracePopulation: 15
+};
+
+function runMCMC(Module, message) {
+    const { seed, cohort, params, nSteps, burnin } = message;
+    const chunkSize = Math.max(1, Math.min(message.chunkSize || 250, nSteps));
+    const maxInfections = Math.max(1, message.maxInfections || 4);
+    const nIndividuals = cohort.ids.length;
+    const totalSamples = cohort.sampleTimes.length;
+    const startTime = performance.now();
+
+    const simulator = Module.ccall('create_serojump_simulator', 'number', ['number'], [seed >>> 0]);
+    let handle = 0;
+    try {
+        // The handle copies the cohort, so the staging buffers go straight away
+        const idsPtr = allocate(Module, Module.HEAP32, cohort.ids, nIndividuals);
+        const timesPtr = allocate(Module, Module.HEAPF64, cohort.sampleTimes, totalSamples);
+        const titresPtr = allocate(Module, Module.HEAPF64, cohort.titreValues, totalSamples);
+        const nSamplesPtr = allocate(Module, Module.HEAP32, cohort.nSamples, nIndividuals);
+        handle = Module.ccall('create_cohort_handle', 'number',
+            ['number', 'number', 'number', 'number', 'number', 'number'],
+            [simulator, nIndividuals, idsPtr, timesPtr, titresPtr, nSamplesPtr]);
+        [idsPtr, timesPtr, titresPtr, nSamplesPtr].forEach(ptr => Module._free(ptr));
+        if (!handle) {
+            throw new Error('create_cohort_handle rejected the cohort (sample times must be ascending)');
+        }
+
+        const modelSet = Module.ccall('cohort_set_model', 'number', new Array(14).fill('number'),
+            [handle, params.studyStart, params.studyEnd, params.infectionRate, maxInfections,
+             params.baselineMean, params.baselineSD, params.boostMean, params.boostSD,
+             params.decayRate, params.observationSD, burnin, message.gibbs ? 1 : 0,
+             message.timeGrid || 0]);
+        if (!modelSet) {
+            throw new Error('cohort_set_model rejected the parameters (infectionRate must be in (0, 1), ' +
+                            'SDs positive and decayRate non-negative)');
+        }
+        const hazard = message.infectionHazard || [];
+        if (hazard.length > 0) {
+            const hazardPtr = allocate(Module, Module.HEAPF64, hazard, hazard.length);
+            const ok = Module.ccall('cohort_set_infection_hazard', 'number', ['number', 'number', 'number'],
+                [handle, hazard.length, hazardPtr]);
+            Module._free(hazardPtr);
+            if (!ok) {
+                throw new Error('infectionHazard must be non-negative with a positive sum');
+            }
+        }
+        if (message.hierarchical) {
+            Module.ccall('cohort_set_hierarchical', 'number', ['number', 'number'], [handle, 1]);
+        }
+
+        for (let firstStep = 0; firstStep < nSteps; firstStep += chunkSize) {
+            const steps = Math.min(chunkSize, nSteps - firstStep);
+            if (!Module.ccall('cohort_step', 'number', ['number', 'number', 'number'], [handle, steps, 1])) {
+                throw new Error('cohort_step failed');
+            }
+
+            const chunk = {
+                type: 'chunk',
+                firstStep,
+                nSteps: steps,
+                baseline: sliceArray(Module, handle, ARRAY.traceBaseline, 'HEAPF64'),
+                boost: sliceArray(Module, handle, ARRAY.traceBoost, 'HEAPF64'),
+                infectionTime: sliceArray(Module, handle, ARRAY.traceInfectionTime, 'HEAPF64'),
+                infectedState: sliceArray(Module, handle, ARRAY.traceInfectionCount, 'HEAP32'),
+                logLikelihood: sliceArray(Module, handle, ARRAY.traceLogLikelihood, 'HEAPF64'),
+                acceptedCounts: sliceArray(Module, handle, ARRAY.acceptedCount, 'HEAP32'),
+                stateInfectionTimes: sliceArray(Module, handle, ARRAY.allInfectionTimes, 'HEAPF64'),
+                stateInfectionCounts: sliceArray(Module, handle, ARRAY.infectionCount, 'HEAP32'),
+                proposalScales: sliceArray(Module, handle, ARRAY.proposalScale, 'HEAPF64')
+            };
+            const transfer = [
+                chunk.baseline.buffer, chunk.boost.buffer, chunk.infectionTime.buffer,
+                chunk.infectedState.buffer, chunk.logLikelihood.buffer, chunk.acceptedCounts.buffer,
+                chunk.stateInfectionTimes.buffer, chunk.stateInfectionCounts.buffer,
+                chunk.proposalScales.buffer
+            ];
+            if (message.hierarchical) {
+                chunk.population = sliceArray(Module, handle, ARRAY.tracePopulation, 'HEAPF64');
+                transfer.push(chunk.population.buffer);
+            }
+            self.postMessage(chunk, transfer);
+        }
+
+        self.postMessage({ type: 'done', elapsedMs: performance.now() - startTime });
+    } finally {
+        if (handle) Module.ccall('destroy_cohort_handle', null, ['number'], [handle]);
+        Module.ccall('destroy_serojump_simulator', null, ['number'], [simulator]);
+    }
+}
+
+modulePromise.then(() => self.postMessage({ type: 'ready' }));
+
+self.onmessage = async (event) => {
+    try {
+        const Module = await modulePromise;
+        if (event.data.type === 'run') {
+            runMCMC(Module, event.data);
+        }
+    } catch (error) {
+        self.postMessage({ type: 'error', message: error.message });
+    }
+};